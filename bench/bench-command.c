@@ -0,0 +1,171 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include "command.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * generator().process() expansion, one input at a time against the
+ * whole input list at once.
+ *
+ * usage: bench-command [--json] [--repeat N] [--min-time MS]
+ */
+
+#define INPUTS 2000
+
+struct input {
+	struct string inputs[INPUTS];
+	struct command_template *command;
+	struct command_template *outputs;
+	struct command_env env;
+	struct string source_dir;
+	struct string build_dir;
+	size_t bytes;
+};
+
+static volatile size_t sink;
+
+static void expand_each(void *arg)
+{
+	struct input *in = arg;
+	struct command_env env = in->env;
+	const char *error = NULL;
+	size_t count = 0;
+
+	for (size_t i = 0; i < INPUTS; i++) {
+		struct command_line *outputs = NULL;
+		struct command_line *line = NULL;
+		struct string names[2];
+
+		command_input_names(in->inputs[i], &names[0], &names[1]);
+		command_env_set(&env, COMMAND_INPUT, &in->inputs[i], 1);
+		command_env_set(&env, COMMAND_PLAINNAME, &names[0], 1);
+		command_env_set(&env, COMMAND_BASENAME, &names[1], 1);
+
+		outputs = command_expand(in->outputs, &env, &error);
+		command_env_set(&env, COMMAND_OUTPUT,
+				outputs->args, outputs->count);
+		line = command_expand(in->command, &env, &error);
+		count += line->count;
+
+		command_line_free(line);
+		command_line_free(outputs);
+	}
+	sink = count;
+}
+
+static void expand_batch(void *arg)
+{
+	struct input *in = arg;
+	struct command_batch *batch = NULL;
+	const char *error = NULL;
+
+	batch = command_expand_batch(in->command, in->outputs, &in->env,
+				     in->inputs, INPUTS, &error);
+	sink = batch->count;
+	command_batch_free(batch);
+}
+
+static bool make_input(struct input *in)
+{
+	const struct string command[] = {
+		CSTRING("protoc"), CSTRING("--proto_path=@CURRENT_SOURCE_DIR@"),
+		CSTRING("--cpp_out=@BUILD_DIR@"), CSTRING("@INPUT@"),
+		CSTRING("--dependency_out=@BUILD_DIR@/@OUTPUT0@.d")
+	};
+	const struct string outputs[] = {
+		CSTRING("@BASENAME@.pb.cc"), CSTRING("@BASENAME@.pb.h")
+	};
+	char name[64];
+
+	for (size_t i = 0; i < INPUTS; i++) {
+		int n = snprintf(name, sizeof(name),
+				 "src/proto/pkg%zu/message%zu.proto", i % 50, i);
+
+		if (!(in->inputs[i] = string_dup_n(name, n)).valid) {
+			return false;
+		}
+		in->bytes += n;
+	}
+	in->command = command_compile(command, ARRAY_SIZE(command));
+	in->outputs = command_compile(outputs, ARRAY_SIZE(outputs));
+	in->source_dir = CSTRING("src/proto");
+	in->build_dir = CSTRING("build/src/proto");
+	command_env_set(&in->env, COMMAND_CURRENT_SOURCE_DIR,
+			&in->source_dir, 1);
+	command_env_set(&in->env, COMMAND_BUILD_DIR, &in->build_dir, 1);
+
+	return in->command != NULL && in->outputs != NULL;
+}
+
+static void free_input(struct input *in)
+{
+	for (size_t i = 0; i < INPUTS; i++) {
+		string_free(&in->inputs[i]);
+	}
+	command_template_free(in->command);
+	command_template_free(in->outputs);
+}
+
+int main(int argc, char **argv)
+{
+	static struct input in;
+	struct bench_options opts;
+
+	static const struct {
+		const char *name;
+		void (* run)(void *arg);
+	} cases[] = {
+		{ "generator/each", expand_each },
+		{ "generator/batch", expand_batch },
+	};
+
+	if (!bench_options_parse(&opts, &argc, argv) || argc != 1) {
+		fprintf(stderr, "usage: %s [--json] [--repeat N] "
+			"[--min-time MS]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (!make_input(&in)) {
+		free_input(&in);
+		return EXIT_FAILURE;
+	}
+
+	bench_begin(&opts);
+	for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+		struct bench_case c = {
+			.name = cases[i].name,
+			.bytes = in.bytes,
+			.run = cases[i].run,
+			.arg = &in
+		};
+		bench_run(&opts, &c);
+	}
+	bench_end(&opts);
+
+	free_input(&in);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,410 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "compare.h"
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Compare two result files written by `bench-* --json`.
+ *
+ * usage: bench-compare [--threshold PCT] BASE.json NEW.json
+ *
+ * For every benchmark present in both files the relative change of the
+ * mean time is printed with a 95% confidence interval (Welch's t-test
+ * over the recorded samples).  A benchmark regresses when it is slower
+ * by more than the threshold beyond that interval, see compare.h.
+ * Exit status is 1 if anything regressed and 2 on errors.
+ */
+
+#define MAX_SAMPLES 1024
+
+struct result {
+	char name[256];
+	size_t count;
+	double samples[MAX_SAMPLES];
+};
+
+struct results {
+	struct result *items;
+	size_t count;
+};
+
+struct reader {
+	const char *path;
+	const char *p;
+	bool error;
+};
+
+static void fail(struct reader *r, const char *what)
+{
+	if (!r->error) {
+		fprintf(stderr, "%s: invalid results: %s\n", r->path, what);
+	}
+	r->error = true;
+}
+
+static void skip_space(struct reader *r)
+{
+	while (isspace((unsigned char) *r->p)) {
+		r->p++;
+	}
+}
+
+static bool accept(struct reader *r, char c)
+{
+	skip_space(r);
+	if (*r->p == c) {
+		r->p++;
+		return true;
+	}
+	return false;
+}
+
+static void expect(struct reader *r, char c)
+{
+	if (!accept(r, c)) {
+		fail(r, "unexpected character");
+	}
+}
+
+/* Reads a string with the escapes the harness writes. */
+static void read_string(struct reader *r, char *buffer, size_t size)
+{
+	size_t n = 0;
+
+	expect(r, '"');
+	while (!r->error && *r->p != '"') {
+		char c = *r->p;
+
+		if (c == '\0') {
+			fail(r, "unterminated string");
+			return;
+		}
+		if (c == '\\' && r->p[1] == 'u') {
+			char digits[5] = { 0 };
+
+			memcpy(digits, r->p + 2, strnlen(r->p + 2, 4));
+			c = (char) strtol(digits, NULL, 16);
+			r->p += 1 + strlen(digits);
+		} else if (c == '\\' && r->p[1] != '\0') {
+			c = *++r->p;
+		}
+		if (n + 1 < size) {
+			buffer[n++] = c;
+		}
+		r->p++;
+	}
+	buffer[n] = '\0';
+	expect(r, '"');
+}
+
+static double read_number(struct reader *r)
+{
+	char *end = NULL;
+	double value = 0;
+
+	skip_space(r);
+	value = strtod(r->p, &end);
+	if (end == r->p) {
+		fail(r, "expected number");
+	}
+	r->p = end;
+
+	return value;
+}
+
+static void skip_value(struct reader *r)
+{
+	char buffer[2];
+
+	skip_space(r);
+	switch (*r->p) {
+	case '{':
+		r->p++;
+		if (accept(r, '}')) {
+			return;
+		}
+		do {
+			read_string(r, buffer, sizeof(buffer));
+			expect(r, ':');
+			skip_value(r);
+		} while (!r->error && accept(r, ','));
+		expect(r, '}');
+		break;
+	case '[':
+		r->p++;
+		if (accept(r, ']')) {
+			return;
+		}
+		do {
+			skip_value(r);
+		} while (!r->error && accept(r, ','));
+		expect(r, ']');
+		break;
+	case '"':
+		read_string(r, buffer, sizeof(buffer));
+		break;
+	default:
+		if (isalpha((unsigned char) *r->p)) {
+			while (isalpha((unsigned char) *r->p)) {
+				r->p++;
+			}
+		} else {
+			read_number(r);
+		}
+		break;
+	}
+}
+
+static void read_result(struct reader *r, struct result *res)
+{
+	char key[64];
+
+	memset(res, 0, sizeof(*res));
+	expect(r, '{');
+	do {
+		read_string(r, key, sizeof(key));
+		expect(r, ':');
+		if (!strcmp(key, "name")) {
+			read_string(r, res->name, sizeof(res->name));
+		} else if (!strcmp(key, "samples")) {
+			expect(r, '[');
+			if (accept(r, ']')) {
+				continue;
+			}
+			do {
+				double value = read_number(r);
+
+				if (res->count < MAX_SAMPLES) {
+					res->samples[res->count++] = value;
+				}
+			} while (!r->error && accept(r, ','));
+			expect(r, ']');
+		} else {
+			skip_value(r);
+		}
+	} while (!r->error && accept(r, ','));
+	expect(r, '}');
+}
+
+static void read_results(struct reader *r, struct results *results)
+{
+	char key[64];
+	struct result *items = NULL;
+
+	expect(r, '{');
+	do {
+		read_string(r, key, sizeof(key));
+		expect(r, ':');
+		if (strcmp(key, "benchmarks") != 0) {
+			skip_value(r);
+			continue;
+		}
+		expect(r, '[');
+		if (accept(r, ']')) {
+			continue;
+		}
+		do {
+			items = realloc(results->items,
+					(results->count + 1) * sizeof(*items));
+			if (items == NULL) {
+				fail(r, "not enough memory");
+				return;
+			}
+			results->items = items;
+			read_result(r, &items[results->count++]);
+		} while (!r->error && accept(r, ','));
+		expect(r, ']');
+	} while (!r->error && accept(r, ','));
+	expect(r, '}');
+}
+
+static bool load(const char *path, struct results *results)
+{
+	struct reader r = { .path = path };
+	FILE *f = NULL;
+	char *text = NULL;
+	long size = 0;
+
+	if ((f = fopen(path, "rb")) == NULL) {
+		perror(path);
+		return false;
+	}
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET) != 0 || (text = malloc(size + 1)) == NULL ||
+	    fread(text, 1, size, f) != (size_t) size) {
+		fprintf(stderr, "%s: cannot read\n", path);
+		fclose(f);
+		free(text);
+		return false;
+	}
+	fclose(f);
+	text[size] = '\0';
+
+	r.p = text;
+	read_results(&r, results);
+	free(text);
+
+	return !r.error;
+}
+
+static const struct result *find(const struct results *results,
+				 const char *name)
+{
+	for (size_t i = 0; i < results->count; i++) {
+		if (!strcmp(results->items[i].name, name)) {
+			return &results->items[i];
+		}
+	}
+	return NULL;
+}
+
+static void mean_var(const struct result *r, double *mean, double *var)
+{
+	double sum = 0;
+
+	for (size_t i = 0; i < r->count; i++) {
+		sum += r->samples[i];
+	}
+	*mean = sum / r->count;
+
+	sum = 0;
+	for (size_t i = 0; i < r->count; i++) {
+		sum += (r->samples[i] - *mean) * (r->samples[i] - *mean);
+	}
+	*var = r->count > 1 ? sum / (r->count - 1) : 0;
+}
+
+/* Two-sided 97.5% quantile of Student's t distribution. */
+static double t_quantile(double df)
+{
+	static const double table[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+		2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+		2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+		2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	size_t n = (size_t) df;
+
+	if (n < 1) {
+		return table[0];
+	}
+	if (n <= ARRAY_SIZE(table)) {
+		return table[n - 1];
+	}
+	return n <= 60 ? 2.000 : n <= 120 ? 1.980 : 1.960;
+}
+
+static bool compare(const struct result *base, const struct result *new,
+		    double threshold)
+{
+	double m1, v1, m2, v2;
+	double se2, se, df, delta, margin;
+	bool regressed = false;
+	const char *verdict = "";
+
+	mean_var(base, &m1, &v1);
+	mean_var(new, &m2, &v2);
+
+	se2 = v1 / base->count + v2 / new->count;
+	se = sqrt(se2);
+	if (base->count > 1 && new->count > 1 && se2 > 0) {
+		df = se2 * se2 /
+			((v1 / base->count) * (v1 / base->count) / (base->count - 1) +
+			 (v2 / new->count) * (v2 / new->count) / (new->count - 1));
+		margin = t_quantile(df) * se / m1 * 100;
+	} else {
+		margin = 0;
+	}
+	delta = (m2 - m1) / m1 * 100;
+
+	switch (compare_verdict(delta, margin, threshold)) {
+	case COMPARE_REGRESSION:
+		verdict = "REGRESSION";
+		regressed = true;
+		break;
+	case COMPARE_IMPROVEMENT:
+		verdict = "improvement";
+		break;
+	case COMPARE_SAME:
+		break;
+	}
+
+	printf("%-32s %14.1f %14.1f %+8.2f%% +/-%6.2f%%  %s\n",
+	       base->name, m1, m2, delta, margin, verdict);
+
+	return regressed;
+}
+
+int main(int argc, char **argv)
+{
+	struct results base = { 0 };
+	struct results new = { 0 };
+	double threshold = 5;
+	int status = EXIT_SUCCESS;
+	int i = 1;
+
+	if (argc == 5 && !strcmp(argv[1], "--threshold")) {
+		threshold = strtod(argv[2], NULL);
+		i = 3;
+	}
+	if (argc - i != 2) {
+		fprintf(stderr, "usage: %s [--threshold PCT] BASE NEW\n", argv[0]);
+		return 2;
+	}
+	if (!load(argv[i], &base) || !load(argv[i + 1], &new)) {
+		free(base.items);
+		free(new.items);
+		return 2;
+	}
+
+	printf("%-32s %14s %14s %9s %11s\n",
+	       "benchmark", "base (ns)", "new (ns)", "delta", "95% CI");
+
+	for (size_t j = 0; j < base.count; j++) {
+		const struct result *b = &base.items[j];
+		const struct result *n = find(&new, b->name);
+
+		if (n == NULL) {
+			printf("%-32s missing in %s\n", b->name, argv[i + 1]);
+		} else if (b->count == 0 || n->count == 0) {
+			printf("%-32s no samples\n", b->name);
+		} else if (compare(b, n, threshold)) {
+			status = EXIT_FAILURE;
+		}
+	}
+	for (size_t j = 0; j < new.count; j++) {
+		if (find(&base, new.items[j].name) == NULL) {
+			printf("%-32s new in %s\n", new.items[j].name, argv[i + 1]);
+		}
+	}
+
+	free(base.items);
+	free(new.items);
+
+	return status;
+}
@@ -0,0 +1,330 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include "common.h"
+#include "lexer.h"
+#include "parser.h"
+#include "synth.h"
+#include <stdlib.h>
+
+/*
+ * Lexer and parser benchmarks.
+ *
+ * usage: bench-parser [--json] [--repeat N] [--min-time MS]
+ *                     [--check-scaling] [FILE...]
+ *
+ * Without files a built-in corpus is used, followed by synthetic
+ * projects of growing size; the time per byte of each relative to the
+ * smallest is printed to stderr.  Wall time is noisy on shared
+ * machines, so only with --check-scaling does the run fail if the
+ * ratio of the largest project exceeds SCALING_TOLERANCE.
+ */
+
+#define SCALING_TOLERANCE 1.5
+
+static const char corpus_unit[] =
+	"project('sample', 'c', version: '1.0.0',\n"
+	"        default_options: ['warning_level=3', 'c_std=c11'])\n"
+	"\n"
+	"cc = meson.get_compiler('c')\n"
+	"deps = [dependency('threads'), cc.find_library('m', required: false)]\n"
+	"conf = configuration_data()\n"
+	"foreach h : ['stdio.h', 'stdlib.h', 'string.h', 'unistd.h']\n"
+	"  conf.set('HAVE_' + h.underscorify().to_upper(), cc.has_header(h))\n"
+	"endforeach\n"
+	"# Sources\n"
+	"src = files('main.c', 'util.c', 'parser.c', 'lexer.c')\n"
+	"if host_machine.system() == 'windows'\n"
+	"  src += files('win32.c')\n"
+	"elif host_machine.system() != 'darwin' and not get_option('tiny')\n"
+	"  src += files('posix.c')\n"
+	"else\n"
+	"  src += []\n"
+	"endif\n"
+	"lib = static_library('sample', src, dependencies: deps,\n"
+	"                     c_args: ['-DVERSION=0x10000', '-DLEVEL=0o7'])\n"
+	"exe = executable('sample', 'tool.c', link_with: lib,\n"
+	"                 install: true, install_dir: get_option('bindir'))\n"
+	"test('basic', exe, args: ['--check', '1'], timeout: 30 * 2)\n"
+	"opts = {'a': 1, 'b': true ? 'x' : 'y', 'c': deps[0]}\n";
+
+struct input {
+	char name[256];
+	struct string text;
+};
+
+static void run_lex(void *arg)
+{
+	struct input *in = arg;
+	struct lexer l;
+	enum token_type token = TOKEN_INVALID;
+
+	lexer_init(&l, in->text);
+	do {
+		token = lex(&l);
+	} while (token != TOKEN_END && token != TOKEN_ERROR);
+	lexer_free(&l);
+}
+
+static void run_parse(void *arg)
+{
+	struct input *in = arg;
+	struct parse_result res;
+
+	res = parse(in->text);
+	parse_result_free(&res);
+}
+
+struct project {
+	struct string *files;
+	size_t count;
+	size_t capacity;
+	size_t bytes;
+};
+
+static bool collect(void *ctx, const char *path, const char *text, size_t length)
+{
+	struct project *p = ctx;
+	struct string *files = NULL;
+
+	UNUSED(path);
+
+	if (p->count == p->capacity) {
+		size_t capacity = p->capacity ? p->capacity * 2 : 64;
+
+		if ((files = realloc(p->files, capacity * sizeof(*files))) == NULL) {
+			return false;
+		}
+		p->files = files;
+		p->capacity = capacity;
+	}
+	if (!(p->files[p->count] = string_dup_n(text, length)).valid) {
+		return false;
+	}
+	p->count++;
+	p->bytes += length;
+
+	return true;
+}
+
+static void project_free(struct project *p)
+{
+	for (size_t i = 0; i < p->count; i++) {
+		string_free(&p->files[i]);
+	}
+	free(p->files);
+	memset(p, 0, sizeof(*p));
+}
+
+static void run_parse_project(void *arg)
+{
+	struct project *p = arg;
+	struct parse_result res;
+
+	for (size_t i = 0; i < p->count; i++) {
+		res = parse(p->files[i]);
+		parse_result_free(&res);
+	}
+}
+
+static bool run_scaling(const struct bench_options *opts, bool check)
+{
+	static const unsigned int scales[] = { 1, 10, 100 };
+	struct synth_options synth = SYNTH_DEFAULTS;
+	struct project p = { 0 };
+	char name[64];
+	struct bench_case c = { .name = name, .run = run_parse_project, .arg = &p };
+	/* Time per byte of each scale */
+	double per_byte[ARRAY_SIZE(scales)];
+	double growth = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(scales); i++) {
+		synth.scale = scales[i];
+		if (!synth_generate(&synth, collect, &p)) {
+			fprintf(stderr, "synth-%ux: cannot generate\n", scales[i]);
+			project_free(&p);
+			return false;
+		}
+		snprintf(name, sizeof(name), "parse/synth-%ux", scales[i]);
+		c.bytes = p.bytes;
+		per_byte[i] = bench_run(opts, &c) / p.bytes;
+		project_free(&p);
+		if (per_byte[i] == 0) {
+			return false;
+		}
+	}
+
+	fprintf(stderr, "parse/synth: time per byte relative to %ux:",
+		scales[0]);
+	for (size_t i = 0; i < ARRAY_SIZE(scales); i++) {
+		fprintf(stderr, "%s %.2f at %ux", i ? "," : "",
+			per_byte[i] / per_byte[0], scales[i]);
+	}
+	fputc('\n', stderr);
+
+	growth = per_byte[ARRAY_SIZE(scales) - 1] / per_byte[0];
+	if (check && growth > SCALING_TOLERANCE) {
+		fprintf(stderr, "parse/synth: time per byte grew %.2fx from "
+			"%ux to %ux, parsing does not scale linearly\n",
+			growth, scales[0], scales[ARRAY_SIZE(scales) - 1]);
+		return false;
+	}
+	return true;
+}
+
+static struct string builtin_corpus(size_t copies)
+{
+	size_t unit = sizeof(corpus_unit) - 1;
+	struct string s = NULL_STRING;
+
+	if ((s = string_alloc(unit * copies)).valid) {
+		for (size_t i = 0; i < copies; i++) {
+			memcpy(string_buffer(s) + i * unit, corpus_unit, unit);
+		}
+	}
+	return s;
+}
+
+static struct string read_file(const char *path)
+{
+	FILE *f = NULL;
+	long size = 0;
+	struct string s = NULL_STRING;
+
+	if ((f = fopen(path, "rb")) == NULL) {
+		perror(path);
+		return s;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 &&
+	    fseek(f, 0, SEEK_SET) == 0 && (s = string_alloc(size)).valid &&
+	    fread(string_buffer(s), 1, size, f) != (size_t) size) {
+		string_free(&s);
+	}
+	if (string_is_null(s)) {
+		fprintf(stderr, "%s: cannot read\n", path);
+	}
+	fclose(f);
+	return s;
+}
+
+static bool check_input(struct input *in)
+{
+	struct parse_result res;
+	bool success = false;
+
+	res = parse(in->text);
+	if (!(success = res.success)) {
+		fprintf(stderr, "%s:%zu:%zu: error: %s\n", in->name,
+			res.location.line, res.location.column,
+			string_is_null(res.error) ?
+			"unknown error" : string_text(res.error));
+	}
+	parse_result_free(&res);
+
+	return success;
+}
+
+static bool run_input(const struct bench_options *opts, struct input *in)
+{
+	char name[300];
+	struct bench_case c = {
+		.name = name,
+		.bytes = string_length(in->text),
+		.arg = in
+	};
+
+	/* Benchmarking a parser that bails out early is meaningless. */
+	if (!check_input(in)) {
+		return false;
+	}
+
+	snprintf(name, sizeof(name), "lex/%s", in->name);
+	c.run = run_lex;
+	bench_run(opts, &c);
+
+	snprintf(name, sizeof(name), "parse/%s", in->name);
+	c.run = run_parse;
+	bench_run(opts, &c);
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_options opts;
+	struct input in;
+	bool check_scaling = false;
+	int status = EXIT_SUCCESS;
+	int n = 1;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--check-scaling")) {
+			check_scaling = true;
+		} else {
+			argv[n++] = argv[i];
+		}
+	}
+	argc = n;
+
+	if (!bench_options_parse(&opts, &argc, argv)) {
+		fprintf(stderr, "usage: %s [--json] [--repeat N] "
+			"[--min-time MS] [--check-scaling] [FILE...]\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	bench_begin(&opts);
+
+	if (argc == 1) {
+		snprintf(in.name, sizeof(in.name), "corpus-64k");
+		if (!(in.text = builtin_corpus(64)).valid) {
+			status = EXIT_FAILURE;
+		} else {
+			if (!run_input(&opts, &in)) {
+				status = EXIT_FAILURE;
+			}
+			string_free(&in.text);
+		}
+		if (!run_scaling(&opts, check_scaling)) {
+			status = EXIT_FAILURE;
+		}
+	}
+
+	for (int i = 1; i < argc; i++) {
+		snprintf(in.name, sizeof(in.name), "%s", argv[i]);
+		if (!(in.text = read_file(argv[i])).valid) {
+			status = EXIT_FAILURE;
+			continue;
+		}
+		if (!run_input(&opts, &in)) {
+			status = EXIT_FAILURE;
+		}
+		string_free(&in.text);
+	}
+
+	bench_end(&opts);
+
+	return status;
+}
@@ -0,0 +1,323 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include "common.h"
+#include "format.h"
+#include "hash.h"
+#include <stdlib.h>
+
+/*
+ * String operations against naive byte-loop baselines, and content
+ * hashes.
+ *
+ * usage: bench-string [--json] [--repeat N] [--min-time MS]
+ */
+
+#define PARTS 4096
+
+struct input {
+	struct string text;
+	struct string parts[PARTS];
+	size_t count;
+	struct format *format;
+};
+
+#define TEMPLATE "@0@/obj/@1@.o"
+
+static volatile size_t sink;
+
+static size_t naive_find(const char *s, size_t length,
+			 const char *needle, size_t n)
+{
+	for (size_t i = 0; i + n <= length; i++) {
+		size_t j = 0;
+
+		while (j < n && s[i + j] == needle[j]) {
+			j++;
+		}
+		if (j == n) {
+			return i;
+		}
+	}
+	return length;
+}
+
+static void contains_naive(void *arg)
+{
+	struct input *in = arg;
+
+	sink = naive_find(string_buffer(in->text), string_length(in->text),
+			  "-Werror", 7);
+}
+
+static void contains_lib(void *arg)
+{
+	struct input *in = arg;
+
+	sink = string_contains(in->text, CSTRING("-Werror"));
+}
+
+static void split_naive(void *arg)
+{
+	struct input *in = arg;
+	const char *s = string_buffer(in->text);
+	size_t length = string_length(in->text);
+	size_t count = 0;
+	size_t start = 0;
+
+	for (size_t i = 0; i < length; i++) {
+		if (s[i] == ' ') {
+			count += i - start;
+			start = i + 1;
+		}
+	}
+	sink = count + length - start;
+}
+
+static void split_lib(void *arg)
+{
+	struct input *in = arg;
+	struct string_split it;
+	struct string part;
+	size_t count = 0;
+
+	string_split_init(&it, in->text, CSTRING(" "));
+	while (string_split_next(&it, &part)) {
+		count += string_length(part);
+	}
+	sink = count;
+}
+
+static void replace_naive(void *arg)
+{
+	struct input *in = arg;
+	const char *s = string_buffer(in->text);
+	size_t length = string_length(in->text);
+	size_t size = 16;
+	size_t n = 0;
+	char *out = malloc(size);
+
+	for (size_t i = 0; i < length; i++) {
+		const char *piece = s + i;
+		size_t piece_len = 1;
+
+		if (i + 1 < length && s[i] == '-' && s[i + 1] == 'I') {
+			piece = "-isystem";
+			piece_len = 8;
+			i++;
+		}
+		while (n + piece_len > size) {
+			size *= 2;
+			out = realloc(out, size);
+		}
+		memcpy(out + n, piece, piece_len);
+		n += piece_len;
+	}
+	sink = n;
+	free(out);
+}
+
+static void replace_lib(void *arg)
+{
+	struct input *in = arg;
+	struct string r;
+
+	r = string_replace(in->text, CSTRING("-I"), CSTRING("-isystem"));
+	sink = string_length(r);
+	string_free(&r);
+}
+
+static void join_naive(void *arg)
+{
+	struct input *in = arg;
+	size_t size = 16;
+	size_t n = 0;
+	char *out = malloc(size);
+
+	for (size_t i = 0; i < in->count; i++) {
+		size_t length = string_length(in->parts[i]) + 1;
+
+		while (n + length > size) {
+			size *= 2;
+			out = realloc(out, size);
+		}
+		memcpy(out + n, string_buffer(in->parts[i]), length - 1);
+		out[n + length - 1] = ' ';
+		n += length;
+	}
+	sink = n;
+	free(out);
+}
+
+static void join_lib(void *arg)
+{
+	struct input *in = arg;
+	struct string r;
+
+	r = string_join(CSTRING(" "), in->parts, in->count);
+	sink = string_length(r);
+	string_free(&r);
+}
+
+/* Rescans the template on every call, one replace per argument. */
+static void format_rescan(void *arg)
+{
+	struct input *in = arg;
+	size_t total = 0;
+
+	for (size_t i = 0; i + 1 < in->count; i += 2) {
+		struct string a = CSTRING(TEMPLATE);
+		struct string b;
+
+		b = string_replace(a, CSTRING("@0@"), in->parts[i]);
+		a = string_replace(b, CSTRING("@1@"), in->parts[i + 1]);
+		total += string_length(a);
+		string_free(&a);
+		string_free(&b);
+	}
+	sink = total;
+}
+
+static void format_compiled(void *arg)
+{
+	struct input *in = arg;
+	size_t total = 0;
+
+	for (size_t i = 0; i + 1 < in->count; i += 2) {
+		struct string r;
+
+		r = format_apply(in->format, &in->parts[i], 2);
+		total += string_length(r);
+		string_free(&r);
+	}
+	sink = total;
+}
+
+static void hash_run(void *arg, enum hash_algorithm algorithm)
+{
+	struct input *in = arg;
+	uint8_t digest[HASH_MAX_SIZE];
+
+	hash_digest(algorithm, string_buffer(in->text),
+		    string_length(in->text), digest);
+	sink = digest[0];
+}
+
+static void hash_xxh64_run(void *arg)
+{
+	hash_run(arg, HASH_xxh64);
+}
+
+static void hash_md5_run(void *arg)
+{
+	hash_run(arg, HASH_md5);
+}
+
+static void hash_sha256_run(void *arg)
+{
+	hash_run(arg, HASH_sha256);
+}
+
+static int format_flag(char *buffer, size_t size, size_t i)
+{
+	return snprintf(buffer, size, i % 2 ? "-DFEATURE_%zu=1 " :
+			"-I/usr/include/pkg%zu ", i);
+}
+
+static bool make_input(struct input *in)
+{
+	struct string_split it;
+	size_t length = 0;
+	char *p = NULL;
+
+	for (size_t i = 0; i < PARTS; i++) {
+		length += format_flag(NULL, 0, i);
+	}
+	if (!(in->text = string_alloc(length)).valid) {
+		return false;
+	}
+	p = string_buffer(in->text);
+	for (size_t i = 0; i < PARTS; i++) {
+		p += format_flag(p, length + 1 - (p - string_buffer(in->text)), i);
+	}
+
+	in->count = 0;
+	string_split_init(&it, in->text, NULL_STRING);
+	while (in->count < PARTS && string_split_next(&it, &in->parts[in->count])) {
+		in->count++;
+	}
+	return (in->format = format_compile(CSTRING(TEMPLATE))) != NULL;
+}
+
+int main(int argc, char **argv)
+{
+	static struct input in;
+	struct bench_options opts;
+
+	static const struct {
+		const char *name;
+		void (* run)(void *arg);
+	} cases[] = {
+		{ "contains/naive", contains_naive },
+		{ "contains/memchr", contains_lib },
+		{ "split/naive", split_naive },
+		{ "split/memchr", split_lib },
+		{ "replace/naive", replace_naive },
+		{ "replace/memchr", replace_lib },
+		{ "join/naive", join_naive },
+		{ "join/sized", join_lib },
+		{ "format/rescan", format_rescan },
+		{ "format/compiled", format_compiled },
+		{ "hash/xxh64", hash_xxh64_run },
+		{ "hash/md5", hash_md5_run },
+		{ "hash/sha256", hash_sha256_run },
+	};
+
+	if (!bench_options_parse(&opts, &argc, argv) || argc != 1) {
+		fprintf(stderr, "usage: %s [--json] [--repeat N] "
+			"[--min-time MS]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (!make_input(&in)) {
+		return EXIT_FAILURE;
+	}
+
+	bench_begin(&opts);
+	for (size_t i = 0; i < ARRAY_SIZE(cases); i++) {
+		struct bench_case c = {
+			.name = cases[i].name,
+			.bytes = string_length(in.text),
+			.run = cases[i].run,
+			.arg = &in
+		};
+		bench_run(&opts, &c);
+	}
+	bench_end(&opts);
+
+	format_free(in.format);
+	string_free(&in.text);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,382 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include "common.h"
+#include "memstats.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define COUNTER_MAP(X)						\
+	X(INSTRUCTIONS, "instructions",				\
+	  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS)	\
+	X(CYCLES, "cycles",					\
+	  PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES)		\
+	X(BRANCH_MISSES, "branch_misses",			\
+	  PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)	\
+	X(L1D_MISSES, "l1d_misses",				\
+	  PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |		\
+	  PERF_COUNT_HW_CACHE_OP_READ << 8 |			\
+	  PERF_COUNT_HW_CACHE_RESULT_MISS << 16)		\
+	X(LLC_MISSES, "llc_misses",				\
+	  PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES)
+
+enum counter {
+#define GEN(N, name, type, config) COUNTER_##N,
+	COUNTER_MAP(GEN)
+#undef GEN
+	COUNTER_COUNT
+};
+
+static const char *const counter_names[] = {
+#define GEN(N, name, type, config) name,
+	COUNTER_MAP(GEN)
+#undef GEN
+};
+
+/* Descriptors of opened counters, -1 if unavailable. */
+static int counters[COUNTER_COUNT];
+/* Descriptor of the group leader, -1 if no counter could be opened */
+static int leader = -1;
+/* Position of each counter in a group read */
+static size_t slots[COUNTER_COUNT];
+
+#ifdef __linux__
+
+static int open_counter(uint32_t type, uint64_t config)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	/* Members follow the leader, which is enabled and disabled */
+	attr.disabled = leader < 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP |
+		PERF_FORMAT_TOTAL_TIME_ENABLED |
+		PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+}
+
+/*
+ * All counters form one group, so that the kernel schedules them
+ * together and their values are comparable even when it has to
+ * multiplex them with other events.
+ */
+static void open_counters(void)
+{
+	size_t n = 0;
+
+	leader = -1;
+#define GEN(N, name, type, config)					\
+	if ((counters[COUNTER_##N] = open_counter(type, config)) >= 0) {\
+		slots[COUNTER_##N] = n++;				\
+		if (leader < 0) {					\
+			leader = counters[COUNTER_##N];			\
+		}							\
+	}
+	COUNTER_MAP(GEN)
+#undef GEN
+}
+
+static void close_counters(void)
+{
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		if (counters[i] >= 0) {
+			close(counters[i]);
+		}
+	}
+	leader = -1;
+}
+
+static void start_counters(void)
+{
+	if (leader >= 0) {
+		ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+}
+
+static void stop_counters(void)
+{
+	if (leader >= 0) {
+		ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	}
+}
+
+/*
+ * Reads the whole group.  Values are scaled by the fraction of time the
+ * group was actually counting; a group that never ran gives nothing.
+ */
+static void read_counters(double *values, bool *valid)
+{
+	uint64_t data[3 + COUNTER_COUNT];
+	double scale = 0;
+	ssize_t n = 0;
+
+	if (leader < 0 ||
+	    (n = read(leader, data, sizeof(data))) < (ssize_t) (3 * sizeof(*data)) ||
+	    data[2] == 0) {
+		return;
+	}
+	scale = (double) data[1] / data[2];
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		if (counters[i] >= 0 && slots[i] < data[0] &&
+		    (3 + slots[i]) * sizeof(*data) < (size_t) n) {
+			values[i] = data[3 + slots[i]] * scale;
+			valid[i] = true;
+		}
+	}
+}
+
+#else
+
+static void open_counters(void)
+{
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		counters[i] = -1;
+	}
+}
+
+static void close_counters(void) {}
+static void start_counters(void) {}
+static void stop_counters(void) {}
+
+static void read_counters(double *values, bool *valid)
+{
+	UNUSED(values);
+	UNUSED(valid);
+}
+
+#endif /* __linux__ */
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint64_t run_loop(const struct bench_case *c, uint64_t iterations)
+{
+	uint64_t start = now();
+
+	for (uint64_t i = 0; i < iterations; i++) {
+		c->run(c->arg);
+	}
+	return now() - start;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+	double x = *(const double *) a;
+	double y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+bool bench_options_parse(struct bench_options *opts, int *argc, char **argv)
+{
+	int n = 1;
+
+	opts->json = false;
+	opts->repeat = 10;
+	opts->min_time = 20000000;
+	opts->out = stdout;
+
+	for (int i = 1; i < *argc; i++) {
+		if (!strcmp(argv[i], "--json")) {
+			opts->json = true;
+		} else if (!strcmp(argv[i], "--repeat") && i + 1 < *argc) {
+			opts->repeat = strtoul(argv[++i], NULL, 10);
+		} else if (!strcmp(argv[i], "--min-time") && i + 1 < *argc) {
+			opts->min_time = strtoull(argv[++i], NULL, 10) * 1000000;
+		} else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+			return false;
+		} else {
+			argv[n++] = argv[i];
+		}
+	}
+	*argc = n;
+
+	return opts->repeat > 0;
+}
+
+static bool first_case;
+
+void bench_begin(const struct bench_options *opts)
+{
+	open_counters();
+	first_case = true;
+
+	if (opts->json) {
+		fputs("{\"benchmarks\":[", opts->out);
+	}
+}
+
+void bench_end(const struct bench_options *opts)
+{
+	close_counters();
+
+	if (opts->json) {
+		fputs("\n]}\n", opts->out);
+	}
+}
+
+static void write_string(FILE *out, const char *s)
+{
+	fputc('"', out);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fprintf(out, "\\%c", *s);
+		} else if ((unsigned char) *s < 0x20) {
+			fprintf(out, "\\u%04x", *s);
+		} else {
+			fputc(*s, out);
+		}
+	}
+	fputc('"', out);
+}
+
+static void report_json(const struct bench_options *opts,
+			const struct bench_case *c, uint64_t iterations,
+			const double *samples, const double *values,
+			const bool *valid, const struct mem_stats *mem)
+{
+	FILE *out = opts->out;
+
+	fprintf(out, "%s\n{\"name\":", first_case ? "" : ",");
+	write_string(out, c->name);
+	fprintf(out, ",\"bytes\":%zu,\"iterations\":%" PRIu64
+		",\"samples\":[", c->bytes, iterations);
+	for (unsigned int i = 0; i < opts->repeat; i++) {
+		fprintf(out, "%s%.1f", i ? "," : "", samples[i]);
+	}
+	fputs("],\"counters\":{", out);
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		fprintf(out, "%s\"%s\":", i ? "," : "", counter_names[i]);
+		if (valid[i]) {
+			fprintf(out, "%.3f", values[i]);
+		} else {
+			fputs("null", out);
+		}
+	}
+	fputs("}", out);
+	if (mem != NULL) {
+		fputs(",\"memory\":", out);
+		mem_stats_write(out, mem);
+	}
+	fputs("}", out);
+}
+
+static void report_text(const struct bench_options *opts,
+			const struct bench_case *c, const double *sorted,
+			const double *values, const bool *valid)
+{
+	FILE *out = opts->out;
+	double median = sorted[opts->repeat / 2];
+
+	fprintf(out, "%-32s %12.1f ns", c->name, median);
+	if (c->bytes != 0) {
+		fprintf(out, " %9.2f MB/s", c->bytes * 1e3 / median);
+		if (valid[COUNTER_INSTRUCTIONS]) {
+			fprintf(out, " %7.2f insn/B",
+				values[COUNTER_INSTRUCTIONS] / c->bytes);
+		}
+	}
+	for (size_t i = COUNTER_BRANCH_MISSES; i < COUNTER_COUNT; i++) {
+		if (valid[i]) {
+			fprintf(out, " %s=%.2f", counter_names[i], values[i]);
+		}
+	}
+	fputc('\n', out);
+}
+
+double bench_run(const struct bench_options *opts, const struct bench_case *c)
+{
+	uint64_t iterations = 1;
+	double median = 0;
+	double values[COUNTER_COUNT] = { 0 };
+	bool valid[COUNTER_COUNT] = { false };
+	struct mem_stats mem;
+	bool have_mem = false;
+	double *samples = NULL;
+
+	if ((samples = mem_alloc(opts->repeat * sizeof(*samples))) == NULL) {
+		fprintf(stderr, "%s: not enough memory\n", c->name);
+		return 0;
+	}
+
+	/* Allocation figures are taken from a single iteration. */
+	mem_stats_reset();
+	c->run(c->arg);
+	have_mem = mem_stats_get(&mem);
+
+	/* Calibrate, which also warms up caches. */
+	while (run_loop(c, iterations) < opts->min_time &&
+	       iterations < (UINT64_C(1) << 40)) {
+		iterations *= 2;
+	}
+
+	start_counters();
+	for (unsigned int i = 0; i < opts->repeat; i++) {
+		samples[i] = (double) run_loop(c, iterations) / iterations;
+	}
+	stop_counters();
+
+	/* Counters are reported per iteration. */
+	read_counters(values, valid);
+	for (size_t i = 0; i < COUNTER_COUNT; i++) {
+		values[i] /= (double) iterations * opts->repeat;
+	}
+
+	/* JSON keeps the samples in the order they were taken. */
+	if (opts->json) {
+		report_json(opts, c, iterations, samples, values, valid,
+			    have_mem ? &mem : NULL);
+	}
+	qsort(samples, opts->repeat, sizeof(*samples), compare_samples);
+	if (!opts->json) {
+		report_text(opts, c, samples, values, valid);
+	}
+	fflush(opts->out);
+	first_case = false;
+	median = samples[opts->repeat / 2];
+
+	mem_free(samples, opts->repeat * sizeof(*samples));
+	return median;
+}
@@ -0,0 +1,75 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "defs.h"
+#include <stdio.h>
+
+/*
+ * Benchmark harness.
+ *
+ * Every case is timed over several repetitions of a calibrated loop.
+ * Hardware counters (instructions, cycles, branch and cache misses) are
+ * read through perf_event_open() where the platform allows it and are
+ * reported as missing otherwise.  They are reported per iteration and
+ * scaled up when the kernel had to multiplex them.
+ */
+
+struct bench_options {
+	bool json;
+	unsigned int repeat;
+	/* Minimal duration of one repetition, in nanoseconds */
+	uint64_t min_time;
+	FILE *out;
+};
+
+struct bench_case {
+	const char *name;
+	/* Input size, for per-byte metrics; zero if not applicable */
+	size_t bytes;
+	void (* run)(void *arg);
+	void *arg;
+};
+
+/**
+ * \brief Parse common options
+ *
+ * Recognized options are removed from argv; positional arguments are
+ * left for the caller.  Returns false on invalid usage.
+ */
+bool bench_options_parse(struct bench_options *opts, int *argc, char **argv);
+
+void bench_begin(const struct bench_options *opts);
+/**
+ * \brief Time a case and report it
+ *
+ * Returns the median time of one iteration in nanoseconds, or zero on
+ * failure.
+ */
+double bench_run(const struct bench_options *opts, const struct bench_case *c);
+void bench_end(const struct bench_options *opts);
+
+#endif /* BENCH_H */
@@ -0,0 +1,57 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include "defs.h"
+
+/*
+ * Verdict of bench-compare on one benchmark.
+ *
+ * delta is the relative change of the mean time and margin the half
+ * width of its 95% confidence interval, both in percent.  A change
+ * counts only if the whole interval lies beyond the threshold, so that
+ * noise cannot turn a small change into a reported one.
+ */
+
+enum compare_verdict {
+	COMPARE_SAME,
+	COMPARE_REGRESSION,
+	COMPARE_IMPROVEMENT,
+};
+
+static inline enum compare_verdict compare_verdict(double delta, double margin,
+						   double threshold)
+{
+	if (delta - margin > threshold) {
+		return COMPARE_REGRESSION;
+	}
+	if (delta + margin < -threshold) {
+		return COMPARE_IMPROVEMENT;
+	}
+	return COMPARE_SAME;
+}
+
+#endif /* COMPARE_H */
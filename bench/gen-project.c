@@ -0,0 +1,169 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "synth.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define make_dir(path) _mkdir(path)
+#else
+#define make_dir(path) mkdir(path, 0777)
+#endif
+
+/*
+ * Write a synthetic project for scaling experiments.
+ *
+ * usage: gen-project [--depth N] [--subdirs N] [--targets N] [--files N]
+ *                    [--deps N] [--options N] [--scale N] [--seed N] DIR
+ *        gen-project --help
+ */
+
+struct output {
+	const char *root;
+	size_t files;
+	size_t bytes;
+};
+
+static bool make_parents(char *path)
+{
+	for (char *p = path + 1; *p != '\0'; p++) {
+		if (*p != '/') {
+			continue;
+		}
+		*p = '\0';
+		if (make_dir(path) != 0 && errno != EEXIST) {
+			perror(path);
+			return false;
+		}
+		*p = '/';
+	}
+	return true;
+}
+
+static bool emit(void *ctx, const char *name, const char *text, size_t length)
+{
+	struct output *out = ctx;
+	char path[4096];
+	FILE *f = NULL;
+	bool ok = false;
+
+	snprintf(path, sizeof(path), "%s/%s", out->root, name);
+	if (!make_parents(path)) {
+		return false;
+	}
+	if ((f = fopen(path, "wb")) == NULL) {
+		perror(path);
+		return false;
+	}
+	ok = fwrite(text, 1, length, f) == length;
+	ok &= fclose(f) == 0;
+	if (!ok) {
+		fprintf(stderr, "%s: write error\n", path);
+	}
+
+	out->files++;
+	out->bytes += length;
+
+	return ok;
+}
+
+static int usage(FILE *out, const char *name, int status)
+{
+	const struct synth_options defaults = SYNTH_DEFAULTS;
+
+	fprintf(out, "usage: %s [OPTION N]... DIR\n\n"
+		"Write a synthetic project into DIR.\n\n"
+		"options (default):\n"
+		"  --depth N    levels of subdirectories below the root (%u)\n"
+		"  --subdirs N  subdirectories per directory (%u)\n"
+		"  --targets N  targets per directory (%u)\n"
+		"  --files N    entries in every files() list (%u)\n"
+		"  --deps N     dependencies of every target (%u)\n"
+		"  --options N  project options (%u)\n"
+		"  --scale N    multiplies the top-level subdirectories (%u)\n"
+		"  --seed N     seed of the generator (%u)\n",
+		name, defaults.depth, defaults.subdirs, defaults.targets,
+		defaults.files, defaults.deps, defaults.options,
+		defaults.scale, defaults.seed);
+	return status;
+}
+
+int main(int argc, char **argv)
+{
+	static const struct {
+		const char *name;
+		size_t offset;
+	} options[] = {
+#define OPTION(name) { "--" #name, offsetof(struct synth_options, name) }
+		OPTION(depth),
+		OPTION(subdirs),
+		OPTION(targets),
+		OPTION(files),
+		OPTION(deps),
+		OPTION(options),
+		OPTION(scale),
+		OPTION(seed),
+#undef OPTION
+	};
+
+	struct synth_options opts = SYNTH_DEFAULTS;
+	struct output out = { 0 };
+	int i = 1;
+
+	if (argc == 2 && (!strcmp(argv[1], "-h") ||
+			  !strcmp(argv[1], "--help"))) {
+		return usage(stdout, argv[0], EXIT_SUCCESS);
+	}
+	for (; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+		size_t j = 0;
+
+		while (j < ARRAY_SIZE(options) && strcmp(argv[i], options[j].name)) {
+			j++;
+		}
+		if (j == ARRAY_SIZE(options)) {
+			break;
+		}
+		*(unsigned int *) ((char *) &opts + options[j].offset) =
+			strtoul(argv[i + 1], NULL, 10);
+	}
+	if (i + 1 != argc || argv[i][0] == '-') {
+		return usage(stderr, argv[0], EXIT_FAILURE);
+	}
+
+	out.root = argv[i];
+	if (make_dir(out.root) != 0 && errno != EEXIST) {
+		perror(out.root);
+		return EXIT_FAILURE;
+	}
+	if (!synth_generate(&opts, emit, &out)) {
+		return EXIT_FAILURE;
+	}
+	printf("%zu files, %zu bytes\n", out.files, out.bytes);
+
+	return EXIT_SUCCESS;
+}
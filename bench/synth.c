@@ -0,0 +1,216 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "synth.h"
+#include "common.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct buffer {
+	char *data;
+	size_t length;
+	size_t size;
+	bool error;
+};
+
+struct state {
+	const struct synth_options *opts;
+	synth_emit emit;
+	void *ctx;
+	uint32_t random;
+	unsigned int dirs;
+	unsigned int declared;
+	struct buffer out;
+};
+
+static void append(struct buffer *b, const char *format, ...)
+{
+	va_list args;
+	int n = 0;
+
+	if (b->error) {
+		return;
+	}
+
+	for (;;) {
+		va_start(args, format);
+		n = vsnprintf(b->data + b->length, b->size - b->length,
+			      format, args);
+		va_end(args);
+
+		if (n < 0) {
+			b->error = true;
+			return;
+		}
+		if ((size_t) n < b->size - b->length) {
+			break;
+		}
+
+		size_t size = b->size ? b->size * 2 : 4096;
+		char *data = NULL;
+
+		while (size - b->length <= (size_t) n) {
+			size *= 2;
+		}
+		if ((data = realloc(b->data, size)) == NULL) {
+			b->error = true;
+			return;
+		}
+		b->data = data;
+		b->size = size;
+	}
+	b->length += n;
+}
+
+/* xorshift32, so that output is identical on every platform. */
+static uint32_t next_random(struct state *s)
+{
+	uint32_t x = s->random;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return s->random = x;
+}
+
+static void gen_target(struct state *s, unsigned int dir, unsigned int t)
+{
+	const struct synth_options *o = s->opts;
+	struct buffer *b = &s->out;
+	unsigned int id = s->declared;
+
+	append(b, "t%u_sources = files(\n", id);
+	for (unsigned int i = 0; i < o->files; i++) {
+		append(b, "  'src_%u_%u.c',\n", t, i);
+	}
+	append(b, ")\n");
+
+	/* A random window of distinct, already declared dependencies. */
+	append(b, "t%u_deps = [", id);
+	if (id > 0) {
+		unsigned int first = next_random(s) % id;
+
+		for (unsigned int i = 0; i < o->deps && i < id; i++) {
+			append(b, "%sdep_%u", i ? ", " : "", (first + i) % id);
+		}
+	}
+	append(b, "]\n");
+
+	if (o->options > 0) {
+		append(b, "if get_option('opt_%u')\n"
+			  "  t%u_sources += files('extra_%u.c')\n"
+			  "endif\n",
+		       next_random(s) % o->options, id, t);
+	}
+
+	append(b, "lib_%u = %s('t%u', t%u_sources,\n"
+		  "  dependencies: t%u_deps,\n"
+		  "  c_args: ['-DDIR=%u', '-DTARGET=%u'],\n"
+		  "  install: %s)\n",
+	       id, t % 2 ? "shared_library" : "static_library",
+	       id, id, id, dir, t, id % 3 == 0 ? "true" : "false");
+	append(b, "dep_%u = declare_dependency(link_with: lib_%u,\n"
+		  "  include_directories: include_directories('.'))\n\n",
+	       id, id);
+
+	s->declared++;
+}
+
+static bool gen_dir(struct state *s, const char *path, unsigned int level)
+{
+	const struct synth_options *o = s->opts;
+	unsigned int dir = s->dirs++;
+	unsigned int subdirs = 0;
+	char file[1024];
+	char sub[1024];
+
+	s->out.length = 0;
+
+	if (level == 0) {
+		append(&s->out, "project('synthetic', 'c',\n"
+				"  version: '1.0.0',\n"
+				"  default_options: ['warning_level=2'])\n\n");
+	}
+	for (unsigned int t = 0; t < o->targets; t++) {
+		gen_target(s, dir, t);
+	}
+
+	if (level < o->depth) {
+		subdirs = o->subdirs * (level == 0 ? o->scale : 1);
+	}
+	for (unsigned int i = 0; i < subdirs; i++) {
+		append(&s->out, "subdir('d%u')\n", i);
+	}
+
+	if (s->out.error) {
+		return false;
+	}
+	snprintf(file, sizeof(file), "%s%smeson.build", path, *path ? "/" : "");
+	if (!s->emit(s->ctx, file, s->out.data, s->out.length)) {
+		return false;
+	}
+
+	for (unsigned int i = 0; i < subdirs; i++) {
+		snprintf(sub, sizeof(sub), "%s%sd%u", path, *path ? "/" : "", i);
+		if (!gen_dir(s, sub, level + 1)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool gen_options(struct state *s)
+{
+	s->out.length = 0;
+
+	for (unsigned int i = 0; i < s->opts->options; i++) {
+		append(&s->out, "option('opt_%u', type: 'boolean', value: %s,\n"
+				"  description: 'Synthetic option %u')\n",
+		       i, i % 2 ? "true" : "false", i);
+	}
+	if (s->out.error) {
+		return false;
+	}
+	return s->emit(s->ctx, "meson_options.txt",
+		       s->out.data, s->out.length);
+}
+
+bool synth_generate(const struct synth_options *opts,
+		    synth_emit emit, void *ctx)
+{
+	struct state s = {
+		.opts = opts,
+		.emit = emit,
+		.ctx = ctx,
+		.random = opts->seed ? opts->seed : 1
+	};
+	bool ok = false;
+
+	ok = gen_options(&s) && gen_dir(&s, "", 0);
+	free(s.out.data);
+
+	return ok;
+}
@@ -0,0 +1,75 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include "defs.h"
+
+/*
+ * Synthetic project generator.
+ *
+ * Produces a deterministic tree of meson.build files (plus
+ * meson_options.txt) shaped by the options below.  The scale factor
+ * multiplies the number of top-level subdirectories, so the total
+ * amount of build description grows linearly with it.
+ */
+
+struct synth_options {
+	/* Levels of nested subdirectories below the root */
+	unsigned int depth;
+	/* Subdirectories per directory */
+	unsigned int subdirs;
+	/* Targets per directory */
+	unsigned int targets;
+	/* Entries in every files() list */
+	unsigned int files;
+	/* Dependencies of every target on previously declared ones */
+	unsigned int deps;
+	/* Number of project options */
+	unsigned int options;
+	unsigned int scale;
+	unsigned int seed;
+};
+
+#define SYNTH_DEFAULTS (struct synth_options) {	\
+	.depth = 2, .subdirs = 3, .targets = 2,	\
+	.files = 10, .deps = 3, .options = 8,	\
+	.scale = 1, .seed = 1			\
+}
+
+/**
+ * \brief Output callback
+ *
+ * Called once per generated file, in the order meson would read them.
+ * Path is relative to the project root.  Returning false stops the
+ * generator.
+ */
+typedef bool (* synth_emit)(void *ctx, const char *path,
+			    const char *text, size_t length);
+
+bool synth_generate(const struct synth_options *opts,
+		    synth_emit emit, void *ctx);
+
+#endif /* SYNTH_H */
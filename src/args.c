@@ -0,0 +1,409 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "args.h"
+
+#define INITIAL_CAPACITY 64
+
+static size_t list_size(size_t count)
+{
+	return sizeof(struct args) + count * sizeof(const struct atom *);
+}
+
+static uint32_t hash_items(const struct atom *const *items, size_t count)
+{
+	return atom_hash(items, count * sizeof(*items));
+}
+
+static const struct args **probe(const struct args **slots, size_t capacity,
+				 uint32_t hash,
+				 const struct atom *const *items, size_t count)
+{
+	size_t mask = capacity - 1;
+	size_t i = hash & mask;
+
+	while (slots[i] != NULL) {
+		const struct args *l = slots[i];
+
+		if (l->hash == hash && l->count == count &&
+		    (count == 0 ||
+		     memcmp(l->items, items, count * sizeof(*items)) == 0)) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+	return &slots[i];
+}
+
+static bool grow(struct args_table *t)
+{
+	size_t capacity = t->capacity ? t->capacity * 2 : INITIAL_CAPACITY;
+	const struct args **slots = NULL;
+
+	if ((slots = mem_alloc_tag(capacity * sizeof(*slots),
+				   MEM_ARGS)) == NULL) {
+		return false;
+	}
+	for (size_t i = 0; i < t->count; i++) {
+		const struct args *l = t->lists[i];
+
+		*probe(slots, capacity, l->hash, l->items, l->count) = l;
+	}
+	if (t->slots != NULL) {
+		mem_free_tag(t->slots, t->capacity * sizeof(*t->slots),
+			     MEM_ARGS);
+	}
+	t->slots = slots;
+	t->capacity = capacity;
+
+	return true;
+}
+
+static bool add_id(struct args_table *t, const struct args *l)
+{
+	if (t->count == t->lists_capacity) {
+		size_t capacity = t->lists_capacity ? t->lists_capacity * 2 :
+			INITIAL_CAPACITY;
+		const struct args **lists = NULL;
+
+		if ((lists = mem_realloc_tag(t->lists,
+					     t->lists_capacity * sizeof(*lists),
+					     capacity * sizeof(*lists),
+					     MEM_ARGS)) == NULL) {
+			return false;
+		}
+		t->lists = lists;
+		t->lists_capacity = capacity;
+	}
+	t->lists[t->count++] = l;
+
+	return true;
+}
+
+bool args_table_init(struct args_table *t, struct atom_table *atoms)
+{
+	memset(t, 0, sizeof(*t));
+	t->atoms = atoms;
+
+	return args_intern(t, NULL, 0) == ARGS_EMPTY;
+}
+
+void args_table_free(struct args_table *t)
+{
+	for (size_t i = 0; i < t->count; i++) {
+		mem_free_tag((void *) t->lists[i],
+			     list_size(t->lists[i]->count), MEM_ARGS);
+	}
+	if (t->lists != NULL) {
+		mem_free_tag(t->lists, t->lists_capacity * sizeof(*t->lists),
+			     MEM_ARGS);
+	}
+	if (t->slots != NULL) {
+		mem_free_tag(t->slots, t->capacity * sizeof(*t->slots),
+			     MEM_ARGS);
+	}
+	memset(t, 0, sizeof(*t));
+}
+
+uint32_t args_intern(struct args_table *t,
+		     const struct atom *const *items, size_t count)
+{
+	uint32_t hash = hash_items(items, count);
+	const struct args **slot = NULL;
+	struct args *l = NULL;
+
+	if (t->capacity > 0) {
+		slot = probe(t->slots, t->capacity, hash, items, count);
+		if (*slot != NULL) {
+			return (*slot)->id;
+		}
+	}
+	if ((t->count + 1) * 4 > t->capacity * 3) {
+		if (!grow(t)) {
+			return ARGS_INVALID;
+		}
+		slot = probe(t->slots, t->capacity, hash, items, count);
+	}
+
+	if (t->count >= ARGS_INVALID ||
+	    (l = mem_alloc_tag(list_size(count), MEM_ARGS)) == NULL) {
+		return ARGS_INVALID;
+	}
+	l->id = t->count;
+	l->hash = hash;
+	l->count = count;
+	if (count > 0) {
+		memcpy(l->items, items, count * sizeof(*items));
+	}
+	if (!add_id(t, l)) {
+		mem_free_tag(l, list_size(count), MEM_ARGS);
+		return ARGS_INVALID;
+	}
+
+	return (*slot = l)->id;
+}
+
+uint32_t args_intern_strings(struct args_table *t,
+			     const struct string *items, size_t count)
+{
+	const struct atom **atoms = NULL;
+	uint32_t id = ARGS_INVALID;
+
+	if (count == 0) {
+		return ARGS_EMPTY;
+	}
+	if ((atoms = mem_alloc_tag(count * sizeof(*atoms), MEM_ARGS)) == NULL) {
+		return ARGS_INVALID;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if ((atoms[i] = atom_intern(t->atoms, items[i])) == NULL) {
+			goto out;
+		}
+	}
+	id = args_intern(t, atoms, count);
+out:
+	mem_free_tag(atoms, count * sizeof(*atoms), MEM_ARGS);
+	return id;
+}
+
+/*
+ * How repeated arguments may be dropped.  Search paths and defines only
+ * count once, so later copies go.  A library must come after everything
+ * that uses it when linking statically, so only its last copy stays.
+ * Anything else may depend on its position and is kept as is.
+ */
+enum kind {
+	KEEP,
+	FIRST,
+	LAST,
+};
+
+/* Flags that take the next argument as their value. */
+static const struct {
+	const char *flag;
+	enum kind kind;
+} pair_flags[] = {
+	{ "-framework", LAST },
+	{ "-isystem", FIRST },
+	{ "-idirafter", FIRST },
+	{ "-iquote", FIRST },
+	{ "-include", KEEP },
+	{ "-imacros", KEEP },
+	{ "-arch", KEEP },
+	{ "-Xlinker", KEEP },
+	{ "-Xassembler", KEEP },
+	{ "-Xpreprocessor", KEEP },
+};
+
+static const char *const first_prefixes[] = {
+	"-I", "-D", "-U", "-L", "-isystem", "-idirafter", "-iquote",
+};
+
+static const char *const library_suffixes[] = {
+	".a", ".so", ".dylib", ".lib",
+};
+
+/* An argument together with its value, if it takes one. */
+struct unit {
+	const struct atom *flag;
+	const struct atom *value;
+	enum kind kind;
+	bool dropped;
+};
+
+static enum kind classify(struct string s)
+{
+	if (string_equal(s, CSTRING("-pthread")) ||
+	    string_equal(s, CSTRING("-pipe"))) {
+		return FIRST;
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(first_prefixes); i++) {
+		if (string_startswith(s, string_from_buf(first_prefixes[i]))) {
+			return FIRST;
+		}
+	}
+	if (string_startswith(s, CSTRING("-l")) ||
+	    string_contains(s, CSTRING(".so."))) {
+		return LAST;
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(library_suffixes); i++) {
+		if (string_endswith(s, string_from_buf(library_suffixes[i]))) {
+			return LAST;
+		}
+	}
+	return KEEP;
+}
+
+/* Groups items into units, returns the number of units. */
+static size_t split_units(const struct args *l, struct unit *units)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < l->count; i++) {
+		struct unit *u = &units[n++];
+		struct string s = atom_string(l->items[i]);
+		size_t j = 0;
+
+		u->flag = l->items[i];
+		u->value = NULL;
+		u->kind = classify(s);
+		u->dropped = false;
+
+		for (j = 0; j < ARRAY_SIZE(pair_flags); j++) {
+			if (string_equal(s, string_from_buf(pair_flags[j].flag))) {
+				break;
+			}
+		}
+		if (j < ARRAY_SIZE(pair_flags) && i + 1 < l->count) {
+			u->value = l->items[++i];
+			u->kind = pair_flags[j].kind;
+		}
+	}
+	return n;
+}
+
+/* Set of units, for filtering repeated arguments. */
+struct seen {
+	const struct unit **slots;
+	size_t mask;
+};
+
+static bool seen_init(struct seen *s, size_t count)
+{
+	size_t capacity = 16;
+
+	while (capacity < count * 2) {
+		capacity *= 2;
+	}
+	s->mask = capacity - 1;
+	s->slots = mem_alloc_tag(capacity * sizeof(*s->slots), MEM_ARGS);
+
+	return s->slots != NULL;
+}
+
+static void seen_clear(struct seen *s)
+{
+	memset(s->slots, 0, (s->mask + 1) * sizeof(*s->slots));
+}
+
+static void seen_free(struct seen *s)
+{
+	mem_free_tag(s->slots, (s->mask + 1) * sizeof(*s->slots), MEM_ARGS);
+}
+
+/* Adds u to the set, returns false if an equal unit was already there. */
+static bool seen_add(struct seen *s, const struct unit *u)
+{
+	uint32_t hash = u->flag->hash;
+	size_t i = 0;
+
+	if (u->value != NULL) {
+		hash ^= u->value->hash * 0x9e3779b1u;
+	}
+	for (i = hash & s->mask; s->slots[i] != NULL; i = (i + 1) & s->mask) {
+		if (s->slots[i]->flag == u->flag &&
+		    s->slots[i]->value == u->value) {
+			return false;
+		}
+	}
+	s->slots[i] = u;
+	return true;
+}
+
+/*
+ * Interns the items of a followed by those of b, dropping repeated
+ * units according to their kind.  Without dedup, repeats of FIRST
+ * units within a are kept.
+ */
+static uint32_t combine(struct args_table *t, const struct args *a,
+			const struct args *b, bool dedup)
+{
+	size_t total = a->count + b->count;
+	const struct atom **items = NULL;
+	struct unit *units = NULL;
+	struct seen seen;
+	size_t count = 0;
+	size_t own = 0;
+	size_t n = 0;
+	uint32_t id = ARGS_INVALID;
+
+	if (!seen_init(&seen, total)) {
+		return ARGS_INVALID;
+	}
+	if ((units = mem_alloc_tag(total * sizeof(*units), MEM_ARGS)) == NULL ||
+	    (items = mem_alloc_tag(total * sizeof(*items), MEM_ARGS)) == NULL) {
+		goto out;
+	}
+	own = split_units(a, units);
+	count = own + split_units(b, units + own);
+
+	for (size_t i = count; i-- > 0;) {
+		if (units[i].kind == LAST && !seen_add(&seen, &units[i])) {
+			units[i].dropped = true;
+		}
+	}
+	seen_clear(&seen);
+	for (size_t i = 0; i < count; i++) {
+		if (units[i].kind == FIRST && !seen_add(&seen, &units[i]) &&
+		    (dedup || i >= own)) {
+			units[i].dropped = true;
+		}
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		if (units[i].dropped) {
+			continue;
+		}
+		items[n++] = units[i].flag;
+		if (units[i].value != NULL) {
+			items[n++] = units[i].value;
+		}
+	}
+	id = args_intern(t, items, n);
+out:
+	if (items != NULL) {
+		mem_free_tag(items, total * sizeof(*items), MEM_ARGS);
+	}
+	if (units != NULL) {
+		mem_free_tag(units, total * sizeof(*units), MEM_ARGS);
+	}
+	seen_free(&seen);
+	return id;
+}
+
+uint32_t args_dedup(struct args_table *t, uint32_t id)
+{
+	if (args_get(t, id)->count < 2) {
+		return id;
+	}
+	return combine(t, args_get(t, id), args_get(t, ARGS_EMPTY), true);
+}
+
+uint32_t args_merge(struct args_table *t, uint32_t a, uint32_t b)
+{
+	if (b == ARGS_EMPTY) {
+		return a;
+	}
+	return combine(t, args_get(t, a), args_get(t, b), false);
+}
@@ -0,0 +1,101 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef ARGS_H
+#define ARGS_H
+
+#include "atom.h"
+
+/*
+ * Interned argument lists.
+ *
+ * Argument lists such as c_args and link_args are immutable vectors of
+ * atoms, stored once per table and referred to by id.  Ids are dense in
+ * the order lists were first interned, which lets a backend emit every
+ * distinct list once; id 0 is always the empty list.
+ */
+
+#define ARGS_EMPTY 0
+#define ARGS_INVALID UINT32_MAX
+
+struct args {
+	uint32_t id;
+	uint32_t hash;
+	uint32_t count;
+	const struct atom *items[];
+};
+
+struct args_table {
+	/* Not owned, may be shared with other tables */
+	struct atom_table *atoms;
+	/* Hash set of lists */
+	const struct args **slots;
+	size_t capacity;
+	/* Lists by id */
+	const struct args **lists;
+	size_t count;
+	size_t lists_capacity;
+};
+
+bool args_table_init(struct args_table *t, struct atom_table *atoms);
+void args_table_free(struct args_table *t);
+
+/* The functions below return ARGS_INVALID on allocation failure. */
+uint32_t args_intern(struct args_table *t,
+		     const struct atom *const *items, size_t count);
+uint32_t args_intern_strings(struct args_table *t,
+			     const struct string *items, size_t count);
+
+/*
+ * Only repeats that are known to be redundant are dropped: search
+ * paths, defines and a few flags such as -pthread keep their first
+ * occurrence, libraries (-l, archives, shared objects and
+ * frameworks) keep their last occurrence so that static link order
+ * stays valid.  Everything else is kept.  Flags that take a separate
+ * value, such as "-Xlinker arg" or "-isystem dir", are handled as one
+ * argument.
+ */
+
+/**
+ * \brief Drop repeated arguments
+ */
+uint32_t args_dedup(struct args_table *t, uint32_t id);
+
+/**
+ * \brief Append the arguments of b to a, dropping repeats
+ *
+ * Search paths and defines repeated within a are kept, so merging
+ * dependency flags into a target's own flags never reorders those.
+ * A library of a that b repeats moves behind b's copy.
+ */
+uint32_t args_merge(struct args_table *t, uint32_t a, uint32_t b);
+
+static inline const struct args *args_get(const struct args_table *t,
+					  uint32_t id)
+{
+	assert(id < t->count);
+	return t->lists[id];
+}
+
+#endif /* ARGS_H */
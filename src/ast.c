@@ -201,7 +201,7 @@ void ast_free(void *ptr)
 		UNREACHABLE();
 	}
 
-	mem_free(ast, ast->size);
+	mem_free_tag(ast, ast->size, MEM_AST_TAG(ast_type(ast)));
 }
 
 void *ast_new(enum ast_type type, enum ast_subtype subtype)
@@ -304,7 +304,7 @@ void *ast_new(enum ast_type type, enum ast_subtype subtype)
 		return NULL;
 	}
 
-	if ((ast = mem_alloc(size)) == NULL) {
+	if ((ast = mem_alloc_tag(size, MEM_AST_TAG(type))) == NULL) {
 		return NULL;
 	}
 	ast->info = AST_MKINFO(type, subtype);
@@ -0,0 +1,139 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "atom.h"
+
+#define INITIAL_CAPACITY 64
+
+uint32_t atom_hash(const void *data, size_t length)
+{
+	const unsigned char *p = data;
+	uint32_t h = 2166136261u;
+
+	for (size_t i = 0; i < length; i++) {
+		h = (h ^ p[i]) * 16777619u;
+	}
+	return h;
+}
+
+void atom_table_init(struct atom_table *t)
+{
+	memset(t, 0, sizeof(*t));
+}
+
+void atom_table_free(struct atom_table *t)
+{
+	for (size_t i = 0; i < t->capacity; i++) {
+		const struct atom *a = t->slots[i];
+
+		if (a != NULL) {
+			mem_free_tag((void *) a, sizeof(*a) + a->length + 1,
+				     MEM_ATOM);
+		}
+	}
+	if (t->slots != NULL) {
+		mem_free_tag(t->slots, t->capacity * sizeof(*t->slots),
+			     MEM_ATOM);
+	}
+	memset(t, 0, sizeof(*t));
+}
+
+/* Open addressing with linear probing, capacity is a power of two. */
+static const struct atom **probe(const struct atom **slots, size_t capacity,
+				 uint32_t hash, struct string s)
+{
+	size_t mask = capacity - 1;
+	size_t i = hash & mask;
+
+	while (slots[i] != NULL) {
+		const struct atom *a = slots[i];
+
+		if (a->hash == hash && a->length == string_length(s) &&
+		    memcmp(a->text, string_buffer(s), a->length) == 0) {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+	return &slots[i];
+}
+
+static bool grow(struct atom_table *t)
+{
+	size_t capacity = t->capacity ? t->capacity * 2 : INITIAL_CAPACITY;
+	const struct atom **slots = NULL;
+
+	if ((slots = mem_alloc_tag(capacity * sizeof(*slots),
+				   MEM_ATOM)) == NULL) {
+		return false;
+	}
+	for (size_t i = 0; i < t->capacity; i++) {
+		const struct atom *a = t->slots[i];
+
+		if (a != NULL) {
+			*probe(slots, capacity, a->hash, atom_string(a)) = a;
+		}
+	}
+	if (t->slots != NULL) {
+		mem_free_tag(t->slots, t->capacity * sizeof(*t->slots),
+			     MEM_ATOM);
+	}
+	t->slots = slots;
+	t->capacity = capacity;
+
+	return true;
+}
+
+const struct atom *atom_intern(struct atom_table *t, struct string s)
+{
+	uint32_t hash = atom_hash(string_buffer(s), string_length(s));
+	const struct atom **slot = NULL;
+	struct atom *a = NULL;
+
+	if (t->capacity > 0) {
+		slot = probe(t->slots, t->capacity, hash, s);
+		if (*slot != NULL) {
+			return *slot;
+		}
+	}
+
+	/* Keep the load factor under 3/4. */
+	if ((t->count + 1) * 4 > t->capacity * 3) {
+		if (!grow(t)) {
+			return NULL;
+		}
+		slot = probe(t->slots, t->capacity, hash, s);
+	}
+
+	if ((a = mem_alloc_tag(sizeof(*a) + string_length(s) + 1,
+			       MEM_ATOM)) == NULL) {
+		return NULL;
+	}
+	a->hash = hash;
+	a->length = string_length(s);
+	memcpy(a->text, string_buffer(s), a->length);
+	a->text[a->length] = '\0';
+
+	t->count++;
+	return *slot = a;
+}
@@ -0,0 +1,68 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef ATOM_H
+#define ATOM_H
+
+#include "common.h"
+
+/*
+ * Interned strings.
+ *
+ * Every distinct string is stored once per table, so atoms from the
+ * same table are equal exactly when their pointers are.  Atoms live
+ * until the table is freed.
+ */
+
+struct atom {
+	uint32_t hash;
+	uint32_t length;
+	char text[];
+};
+
+struct atom_table {
+	const struct atom **slots;
+	size_t capacity;
+	size_t count;
+};
+
+void atom_table_init(struct atom_table *t);
+void atom_table_free(struct atom_table *t);
+
+/**
+ * \brief Intern a string
+ *
+ * Returns null only on allocation failure.
+ */
+const struct atom *atom_intern(struct atom_table *t, struct string s);
+
+/* FNV-1a, also used to hash structures built from atoms. */
+uint32_t atom_hash(const void *data, size_t length);
+
+static inline struct string atom_string(const struct atom *a)
+{
+	return string_from_buf_n(a->text, a->length);
+}
+
+#endif /* ATOM_H */
@@ -0,0 +1,562 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "command.h"
+
+#define LITERAL COMMAND_VAR_COUNT
+#define ONLY_ITEM UINT32_MAX
+
+const char *command_var_name(enum command_var var)
+{
+	switch (var) {
+#define GEN(N) \
+	case COMMAND_##N: return #N;
+		COMMAND_VAR_MAP(GEN)
+#undef GEN
+	default: return "unknown";
+	}
+}
+
+static bool lookup(const char *name, size_t length, uint32_t *var)
+{
+	for (uint32_t i = 0; i < COMMAND_VAR_COUNT; i++) {
+		const char *s = command_var_name(i);
+
+		if (strlen(s) == length && memcmp(s, name, length) == 0) {
+			*var = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Matches a placeholder at p, returns its length or 0. */
+static size_t placeholder(const char *p, const char *end,
+			  uint32_t *var, uint32_t *index)
+{
+	const char *q = p + 1;
+	const char *name_end = NULL;
+	uint64_t n = 0;
+
+	while (q < end && ((*q >= 'A' && *q <= 'Z') || *q == '_')) {
+		q++;
+	}
+	name_end = q;
+	while (q < end && *q >= '0' && *q <= '9') {
+		if ((n = n * 10 + (*q - '0')) >= ONLY_ITEM) {
+			n = ONLY_ITEM - 1;
+		}
+		q++;
+	}
+	if (q == end || *q != '@' || !lookup(p + 1, name_end - p - 1, var)) {
+		return 0;
+	}
+	*index = q > name_end ? (uint32_t) n : ONLY_ITEM;
+	return q + 1 - p;
+}
+
+typedef void (*emit_fn)(void *ctx, uint32_t var, uint32_t index,
+			const char *text, size_t length);
+
+/* Calls emit() for every segment of s in order. */
+static void scan(struct string s, emit_fn emit, void *ctx)
+{
+	const char *p = string_buffer(s);
+	const char *end = p + string_length(s);
+	const char *lit = p;
+
+	while ((p = memchr(p, '@', end - p)) != NULL) {
+		uint32_t var = 0;
+		uint32_t index = 0;
+		size_t n = 0;
+
+		if ((n = placeholder(p, end, &var, &index)) == 0) {
+			p++;
+			continue;
+		}
+		if (p > lit) {
+			emit(ctx, LITERAL, 0, lit, p - lit);
+		}
+		emit(ctx, var, index, NULL, 0);
+		lit = p += n;
+	}
+	if (end > lit) {
+		emit(ctx, LITERAL, 0, lit, end - lit);
+	}
+}
+
+/* Segments of one argument, as seen by the first pass. */
+struct measure {
+	size_t segments;
+	size_t placeholders;
+	size_t literal_length;
+	uint32_t var;
+	uint32_t index;
+	unsigned int uses;
+};
+
+static void measure(void *ctx, uint32_t var, uint32_t index,
+		    const char *text, size_t length)
+{
+	struct measure *m = ctx;
+
+	UNUSED(text);
+	m->segments++;
+	if (var == LITERAL) {
+		m->literal_length += length;
+	} else {
+		m->placeholders++;
+		m->var = var;
+		m->index = index;
+		m->uses |= COMMAND_VAR_BIT(var);
+	}
+}
+
+static enum command_arg_kind classify(const struct measure *m)
+{
+	if (m->placeholders == 0) {
+		return COMMAND_ARG_LITERAL;
+	}
+	if (m->segments == 1 && m->index == ONLY_ITEM) {
+		return COMMAND_ARG_LIST;
+	}
+	return COMMAND_ARG_SEGMENTS;
+}
+
+struct fill {
+	struct command_template *t;
+	size_t segments;
+	char *text;
+};
+
+static void fill(void *ctx, uint32_t var, uint32_t index,
+		 const char *text, size_t length)
+{
+	struct fill *state = ctx;
+	struct command_segment *seg = &state->t->segments[state->segments++];
+
+	seg->var = var;
+	seg->index = index;
+	if (var == LITERAL) {
+		seg->text = memcpy(state->text, text, length);
+		seg->length = length;
+		state->text += length;
+	}
+}
+
+struct command_template *command_compile(const struct string *args,
+					 size_t count)
+{
+	struct command_template *t = NULL;
+	struct fill state = { NULL, 0, NULL };
+	size_t segments = 0;
+	size_t text = 0;
+	size_t size = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		struct measure m = { 0 };
+
+		scan(args[i], measure, &m);
+		switch (classify(&m)) {
+		case COMMAND_ARG_LITERAL:
+			/* Literal arguments keep a terminator. */
+			text += string_length(args[i]) + 1;
+			break;
+		case COMMAND_ARG_LIST:
+			break;
+		case COMMAND_ARG_SEGMENTS:
+			segments += m.segments;
+			text += m.literal_length;
+			break;
+		}
+	}
+
+	size = sizeof(*t) + count * sizeof(t->args[0]) +
+		segments * sizeof(t->segments[0]) + text;
+	if ((t = mem_alloc_tag(size, MEM_COMMAND)) == NULL) {
+		return NULL;
+	}
+	t->size = size;
+	t->count = count;
+	t->args = (struct command_arg *) (t + 1);
+	t->segments = (struct command_segment *) (t->args + count);
+	state.t = t;
+	state.text = (char *) (t->segments + segments);
+
+	for (size_t i = 0; i < count; i++) {
+		struct command_arg *arg = &t->args[i];
+		struct measure m = { 0 };
+
+		scan(args[i], measure, &m);
+		t->uses |= m.uses;
+		switch ((arg->kind = classify(&m))) {
+		case COMMAND_ARG_LITERAL:
+			memcpy(state.text, string_buffer(args[i]),
+			       string_length(args[i]));
+			state.text[string_length(args[i])] = '\0';
+			arg->text = string_from_buf_n(state.text,
+						      string_length(args[i]));
+			state.text += string_length(args[i]) + 1;
+			t->literal_length += string_length(args[i]);
+			t->fixed++;
+			break;
+		case COMMAND_ARG_LIST:
+			arg->var = m.var;
+			break;
+		case COMMAND_ARG_SEGMENTS:
+			arg->first = state.segments;
+			arg->count = m.segments;
+			scan(args[i], fill, &state);
+			t->literal_length += m.literal_length;
+			t->fixed++;
+			break;
+		}
+	}
+
+	return t;
+}
+
+void command_template_free(struct command_template *t)
+{
+	if (t != NULL) {
+		mem_free_tag(t, t->size, MEM_COMMAND);
+	}
+}
+
+void command_input_names(struct string input, struct string *plainname,
+			 struct string *basename)
+{
+	const char *p = string_buffer(input);
+	size_t length = string_length(input);
+	size_t start = length;
+	size_t dot = length;
+
+	while (start > 0 && p[start - 1] != '/') {
+		start--;
+	}
+	/* A leading dot, as in `.clang-format', starts no extension. */
+	for (size_t i = length; i > start + 1; i--) {
+		if (p[i - 1] == '.') {
+			dot = i - 1;
+			break;
+		}
+	}
+	*plainname = string_slice(input, start, length - start);
+	*basename = string_slice(input, start, dot - start);
+}
+
+static bool value(const struct command_env *env,
+		  const struct command_segment *seg,
+		  struct string *v, const char **error)
+{
+	size_t count = env->vars[seg->var].count;
+
+	if (seg->index == ONLY_ITEM) {
+		if (count != 1) {
+			*error = count == 0 ?
+				"placeholder refers to an empty list" :
+				"placeholder in an argument refers to "
+				"more than one item";
+			return false;
+		}
+		*v = env->vars[seg->var].items[0];
+	} else {
+		if (seg->index >= count) {
+			*error = "placeholder index out of range";
+			return false;
+		}
+		*v = env->vars[seg->var].items[seg->index];
+	}
+	return true;
+}
+
+/* Sizes the argument built from segments, including its terminator. */
+static bool measure_arg(const struct command_template *t,
+			const struct command_arg *arg,
+			const struct command_env *env,
+			size_t *length, const char **error)
+{
+	const struct command_segment *seg = &t->segments[arg->first];
+	const struct command_segment *end = seg + arg->count;
+	struct string v;
+
+	*length = 1;
+	for (; seg < end; seg++) {
+		if (seg->var == LITERAL) {
+			*length += seg->length;
+		} else if (value(env, seg, &v, error)) {
+			*length += string_length(v);
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+static char *fill_arg(const struct command_template *t,
+		      const struct command_arg *arg,
+		      const struct command_env *env,
+		      char *out, struct string *result)
+{
+	const struct command_segment *seg = &t->segments[arg->first];
+	const struct command_segment *end = seg + arg->count;
+	const char *start = out;
+	const char *error = NULL;
+	struct string v;
+
+	for (; seg < end; seg++) {
+		if (seg->var == LITERAL) {
+			v = string_from_buf_n(seg->text, seg->length);
+		} else {
+			/* Checked by measure_arg(). */
+			value(env, seg, &v, &error);
+		}
+		memcpy(out, string_buffer(v), string_length(v));
+		out += string_length(v);
+	}
+	*out = '\0';
+	*result = string_from_buf_n(start, out - start);
+
+	return out + 1;
+}
+
+/*
+ * Counts the arguments of the expanded command and the bytes of text to
+ * build.  If lengths is not null it receives one string per argument
+ * with the right length; those built from segments have no text yet,
+ * which is enough for measuring a command that refers to them.
+ */
+static bool measure_line(const struct command_template *t,
+			 const struct command_env *env,
+			 struct string *lengths,
+			 size_t *count, size_t *text, const char **error)
+{
+	*count = t->fixed;
+	*text = 0;
+
+	for (size_t i = 0; i < t->count; i++) {
+		const struct command_arg *arg = &t->args[i];
+		size_t length = 0;
+
+		switch (arg->kind) {
+		case COMMAND_ARG_LITERAL:
+			if (lengths != NULL) {
+				*lengths++ = arg->text;
+			}
+			break;
+		case COMMAND_ARG_LIST:
+			*count += env->vars[arg->var].count;
+			for (size_t j = 0; lengths != NULL &&
+				     j < env->vars[arg->var].count; j++) {
+				*lengths++ = env->vars[arg->var].items[j];
+			}
+			break;
+		case COMMAND_ARG_SEGMENTS:
+			if (!measure_arg(t, arg, env, &length, error)) {
+				return false;
+			}
+			if (lengths != NULL) {
+				*lengths++ = string_from_buf_n(NULL, length - 1);
+			}
+			*text += length;
+			break;
+		}
+	}
+	return true;
+}
+
+/* Fills args and the text at out as measured, returns the text end. */
+static char *fill_line(const struct command_template *t,
+		       const struct command_env *env,
+		       struct string *args, char *out)
+{
+	for (size_t i = 0; i < t->count; i++) {
+		const struct command_arg *arg = &t->args[i];
+
+		switch (arg->kind) {
+		case COMMAND_ARG_LITERAL:
+			*args++ = arg->text;
+			break;
+		case COMMAND_ARG_LIST:
+			for (size_t j = 0; j < env->vars[arg->var].count; j++) {
+				*args++ = env->vars[arg->var].items[j];
+			}
+			break;
+		case COMMAND_ARG_SEGMENTS:
+			out = fill_arg(t, arg, env, out, args++);
+			break;
+		}
+	}
+	return out;
+}
+
+struct command_line *command_expand(const struct command_template *t,
+				    const struct command_env *env,
+				    const char **error)
+{
+	struct command_line *line = NULL;
+	size_t count = 0;
+	size_t text = 0;
+	size_t size = 0;
+
+	if (!measure_line(t, env, NULL, &count, &text, error)) {
+		return NULL;
+	}
+
+	size = sizeof(*line) + count * sizeof(line->args[0]) + text;
+	if ((line = mem_alloc_tag(size, MEM_COMMAND)) == NULL) {
+		*error = "out of memory";
+		return NULL;
+	}
+	line->size = size;
+	line->count = count;
+	fill_line(t, env, line->args, (char *) &line->args[count]);
+
+	return line;
+}
+
+void command_line_free(struct command_line *line)
+{
+	if (line != NULL) {
+		mem_free_tag(line, line->size, MEM_COMMAND);
+	}
+}
+
+/* Number of arguments of the expanded command, without measuring text. */
+static size_t line_count(const struct command_template *t,
+			 const struct command_env *env)
+{
+	size_t count = t->fixed;
+
+	for (size_t i = 0; i < t->count; i++) {
+		if (t->args[i].kind == COMMAND_ARG_LIST) {
+			count += env->vars[t->args[i].var].count;
+		}
+	}
+	return count;
+}
+
+static void set_input(struct command_env *env, const struct string *input,
+		      struct string names[2])
+{
+	command_input_names(*input, &names[0], &names[1]);
+	command_env_set(env, COMMAND_INPUT, input, 1);
+	command_env_set(env, COMMAND_PLAINNAME, &names[0], 1);
+	command_env_set(env, COMMAND_BASENAME, &names[1], 1);
+}
+
+struct command_batch *command_expand_batch(const struct command_template *t,
+					   const struct command_template *outputs,
+					   const struct command_env *env,
+					   const struct string *inputs,
+					   size_t count, const char **error)
+{
+	struct command_env e = *env;
+	struct command_batch *batch = NULL;
+	struct string names[2];
+	struct string *lengths = NULL;
+	size_t output_count = 0;
+	size_t strings = 0;
+	size_t text = 0;
+	size_t size = 0;
+	struct string *vec = NULL;
+	char *out = NULL;
+
+	/*
+	 * The per-input variables are single items, so every input has
+	 * the same number of outputs.
+	 */
+	if (count > 0) {
+		set_input(&e, &inputs[0], names);
+		output_count = line_count(outputs, &e);
+	}
+	if (output_count > 0 &&
+	    (lengths = mem_alloc_tag(output_count * sizeof(*lengths),
+				     MEM_COMMAND)) == NULL) {
+		*error = "out of memory";
+		return NULL;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		size_t n = 0;
+		size_t length = 0;
+
+		set_input(&e, &inputs[i], names);
+		if (!measure_line(outputs, &e, lengths, &n, &length, error)) {
+			goto fail;
+		}
+		assert(n == output_count);
+		strings += n;
+		text += length;
+
+		command_env_set(&e, COMMAND_OUTPUT, lengths, n);
+		if (!measure_line(t, &e, NULL, &n, &length, error)) {
+			goto fail;
+		}
+		strings += n;
+		text += length;
+	}
+
+	size = sizeof(*batch) + count * sizeof(batch->edges[0]) +
+		strings * sizeof(*vec) + text;
+	if ((batch = mem_alloc_tag(size, MEM_COMMAND)) == NULL) {
+		*error = "out of memory";
+		goto fail;
+	}
+	batch->size = size;
+	batch->count = count;
+	vec = (struct string *) &batch->edges[count];
+	out = (char *) (vec + strings);
+
+	for (size_t i = 0; i < count; i++) {
+		struct command_edge *edge = &batch->edges[i];
+
+		set_input(&e, &inputs[i], names);
+		edge->input = inputs[i];
+		edge->outputs = vec;
+		edge->output_count = output_count;
+		out = fill_line(outputs, &e, vec, out);
+		vec += output_count;
+
+		command_env_set(&e, COMMAND_OUTPUT, edge->outputs, output_count);
+		edge->args = vec;
+		edge->count = line_count(t, &e);
+		out = fill_line(t, &e, vec, out);
+		vec += edge->count;
+	}
+
+fail:
+	if (lengths != NULL) {
+		mem_free_tag(lengths, output_count * sizeof(*lengths),
+			     MEM_COMMAND);
+	}
+	return batch;
+}
+
+void command_batch_free(struct command_batch *batch)
+{
+	if (batch != NULL) {
+		mem_free_tag(batch, batch->size, MEM_COMMAND);
+	}
+}
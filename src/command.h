@@ -0,0 +1,202 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include "common.h"
+
+/*
+ * Command templates for custom_target() and generator().
+ *
+ * A command array such as [prog, '@INPUT@', '-o', '@OUTPUT@'] is
+ * compiled once.  Arguments without placeholders become literals,
+ * an argument that is exactly a list placeholder expands to every item
+ * of the list, and other arguments become segment lists that are
+ * filled in like format templates.  Expanding the template for an input
+ * then needs no parsing, only copying into a vector sized in advance.
+ *
+ * Placeholders are @NAME@ and, for any list, @NAMEn@ for its n-th item.
+ * Text between `@' that does not name a variable is kept as is.
+ */
+
+#define COMMAND_VAR_MAP(X)		\
+	X(INPUT)			\
+	X(OUTPUT)			\
+	X(EXTRA_ARGS)			\
+	X(PLAINNAME)			\
+	X(BASENAME)			\
+	X(OUTDIR)			\
+	X(PRIVATE_DIR)			\
+	X(DEPFILE)			\
+	X(BUILD_DIR)			\
+	X(CURRENT_SOURCE_DIR)		\
+	X(SOURCE_ROOT)			\
+	X(BUILD_ROOT)
+
+enum command_var {
+#define GEN(N) COMMAND_##N,
+	COMMAND_VAR_MAP(GEN)
+#undef GEN
+	COMMAND_VAR_COUNT
+};
+
+#define COMMAND_VAR_BIT(var) (1u << (var))
+
+struct command_segment {
+	/* Variable, or COMMAND_VAR_COUNT for literal text */
+	uint32_t var;
+	/* Item of the list, or UINT32_MAX for the only item */
+	uint32_t index;
+	uint32_t length;
+	const char *text;
+};
+
+enum command_arg_kind {
+	COMMAND_ARG_LITERAL,
+	COMMAND_ARG_LIST,
+	COMMAND_ARG_SEGMENTS
+};
+
+struct command_arg {
+	enum command_arg_kind kind;
+	/* COMMAND_ARG_LIST */
+	enum command_var var;
+	/* COMMAND_ARG_LITERAL */
+	struct string text;
+	/* COMMAND_ARG_SEGMENTS */
+	uint32_t first;
+	uint32_t count;
+};
+
+struct command_template {
+	size_t size;
+	size_t count;
+	struct command_arg *args;
+	struct command_segment *segments;
+	/* Arguments other than COMMAND_ARG_LIST ones */
+	size_t fixed;
+	/* Total length of all literal text */
+	size_t literal_length;
+	/* COMMAND_VAR_BIT() of every variable used */
+	unsigned int uses;
+};
+
+/* Values of the variables, scalars are lists of one item. */
+struct command_env {
+	struct {
+		const struct string *items;
+		size_t count;
+	} vars[COMMAND_VAR_COUNT];
+};
+
+/*
+ * An expanded command: a vector of arguments together with the text of
+ * the arguments that had to be built, in one allocation.  Literal and
+ * list arguments refer to the template and to the environment, which
+ * must outlive it.
+ */
+struct command_line {
+	size_t size;
+	size_t count;
+	struct string args[];
+};
+
+/**
+ * \brief Compile a command array
+ *
+ * Text is copied, the arguments need not outlive the template.
+ */
+struct command_template *command_compile(const struct string *args,
+					 size_t count);
+void command_template_free(struct command_template *t);
+
+static inline void command_env_set(struct command_env *env,
+				   enum command_var var,
+				   const struct string *items, size_t count)
+{
+	env->vars[var].items = items;
+	env->vars[var].count = count;
+}
+
+/**
+ * \brief Input file names for @PLAINNAME@ and @BASENAME@
+ *
+ * The name of the input without directories, and that name without its
+ * last extension, both as views into input.
+ */
+void command_input_names(struct string input, struct string *plainname,
+			 struct string *basename);
+
+/**
+ * \brief Expand a template
+ *
+ * Returns null and sets error on failure: a placeholder inside an
+ * argument refers to a missing item, or to a list with more than one
+ * item without saying which, or the allocation failed.
+ */
+struct command_line *command_expand(const struct command_template *t,
+				    const struct command_env *env,
+				    const char **error);
+void command_line_free(struct command_line *line);
+
+/*
+ * generator().process() over a list of inputs.  Every input becomes an
+ * edge with its output names and its expanded command; all edges are
+ * built in one allocation.
+ */
+
+struct command_edge {
+	struct string input;
+	struct string *outputs;
+	size_t output_count;
+	struct string *args;
+	size_t count;
+};
+
+struct command_batch {
+	size_t size;
+	size_t count;
+	struct command_edge edges[];
+};
+
+/**
+ * \brief Expand a generator for every input
+ *
+ * For each input, @INPUT@, @PLAINNAME@ and @BASENAME@ are set from it,
+ * the output name templates are expanded, and then the command is
+ * expanded with @OUTPUT@ set to those names.  Other variables come from
+ * env.  The inputs and env must outlive the batch.  Returns null and
+ * sets error like command_expand().
+ */
+struct command_batch *command_expand_batch(const struct command_template *t,
+					   const struct command_template *outputs,
+					   const struct command_env *env,
+					   const struct string *inputs,
+					   size_t count, const char **error);
+void command_batch_free(struct command_batch *batch);
+
+const char *command_var_name(enum command_var var);
+
+#endif /* COMMAND_H */
@@ -23,34 +23,55 @@
  */
 
 #include "common.h"
+#include "memstats.h"
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
-void *mem_alloc(size_t size)
+void *mem_alloc_tag(size_t size, enum mem_tag tag)
 {
 	void *ptr = NULL;
 
 	if ((ptr = malloc(size)) != NULL) {
 		memset(ptr, 0, size);
+		MEM_STATS_ALLOC(tag, size);
 	}
 
 	return ptr;
 }
 
-void mem_free(void *ptr, size_t size)
+/* Unlike mem_alloc_tag() does not clear the grown tail. */
+void *mem_realloc_tag(void *ptr, size_t old_size, size_t size,
+		      enum mem_tag tag)
+{
+	void *new_ptr = NULL;
+
+	if ((new_ptr = realloc(ptr, size)) != NULL) {
+		MEM_STATS_FREE(tag, old_size);
+		MEM_STATS_ALLOC(tag, size);
+	}
+
+	return new_ptr;
+}
+
+void mem_free_tag(void *ptr, size_t size, enum mem_tag tag)
 {
 	memset(ptr, 0, size);
 	free(ptr);
+	MEM_STATS_FREE(tag, size);
 }
 
+/* Contents are left uninitialized, only the terminator is set. */
 struct string string_alloc(size_t length)
 {
 	struct string_data *d = NULL;
 
-	if ((d = mem_alloc(sizeof(*d) + length + 1)) == NULL) {
+	if ((d = malloc(sizeof(*d) + length + 1)) == NULL) {
 		return NULL_STRING;
 	}
+	MEM_STATS_ALLOC(MEM_STRING, sizeof(*d) + length + 1);
 	d->buffer = (void *) (d + 1);
+	d->buffer[length] = '\0';
 	d->length = length;
 
 	return (struct string) { .data = d, .valid = 1, .length = length };
@@ -77,7 +98,10 @@ void string_free(struct string *s)
 {
 	if (!s->raw) {
 		if (s->data != NULL) {
-			mem_free(s->data, 0);
+			/* Like string_alloc(), skips clearing the contents */
+			MEM_STATS_FREE(MEM_STRING,
+				       sizeof(*s->data) + s->data->length + 1);
+			free(s->data);
 		}
 	}
 	*s = NULL_STRING;
@@ -102,3 +126,257 @@ bool string_equal(struct string a, struct string b)
 	return length == string_length(b) &&
 		memcmp(string_buffer(a), string_buffer(b), length) == 0;
 }
+
+/*
+ * Searches are built on memchr(), which C libraries implement with
+ * vector instructions, to skip to candidate positions.
+ */
+static const char *find(const char *s, size_t length,
+			const char *needle, size_t n)
+{
+	const char *end = s + length;
+	const char *p = s;
+
+	if (n == 0) {
+		return s;
+	}
+	while ((size_t) (end - p) >= n &&
+	       (p = memchr(p, needle[0], end - p - n + 1)) != NULL) {
+		if (memcmp(p + 1, needle + 1, n - 1) == 0) {
+			return p;
+		}
+		p++;
+	}
+	return NULL;
+}
+
+struct string string_slice(struct string s, size_t start, size_t length)
+{
+	assert(start + length <= string_length(s));
+
+	return string_from_buf_n(string_buffer(s) + start, length);
+}
+
+bool string_find(struct string s, struct string needle, size_t *pos)
+{
+	const char *text = string_buffer(s);
+	const char *p = NULL;
+
+	p = find(text, string_length(s),
+		 string_buffer(needle), string_length(needle));
+	if (p != NULL && pos != NULL) {
+		*pos = p - text;
+	}
+	return p != NULL;
+}
+
+bool string_contains(struct string s, struct string needle)
+{
+	return string_find(s, needle, NULL);
+}
+
+bool string_startswith(struct string s, struct string prefix)
+{
+	size_t n = string_length(prefix);
+
+	return n <= string_length(s) &&
+		memcmp(string_buffer(s), string_buffer(prefix), n) == 0;
+}
+
+bool string_endswith(struct string s, struct string suffix)
+{
+	size_t n = string_length(suffix);
+	size_t length = string_length(s);
+
+	return n <= length &&
+		memcmp(string_buffer(s) + length - n,
+		       string_buffer(suffix), n) == 0;
+}
+
+size_t string_count(struct string s, struct string needle)
+{
+	const char *p = string_buffer(s);
+	const char *end = p + string_length(s);
+	size_t n = string_length(needle);
+	size_t count = 0;
+
+	if (n == 0) {
+		return 0;
+	}
+	while ((p = find(p, end - p, string_buffer(needle), n)) != NULL) {
+		p += n;
+		count++;
+	}
+	return count;
+}
+
+struct string string_strip(struct string s, struct string chars)
+{
+	bool set[256] = { false };
+	const unsigned char *p = (const unsigned char *) string_buffer(s);
+	size_t start = 0;
+	size_t end = string_length(s);
+
+	if (string_is_null(chars)) {
+		for (int c = 0; c < 256; c++) {
+			set[c] = isspace(c);
+		}
+	} else {
+		for (size_t i = 0; i < string_length(chars); i++) {
+			set[(unsigned char) string_buffer(chars)[i]] = true;
+		}
+	}
+
+	while (start < end && set[p[start]]) {
+		start++;
+	}
+	while (end > start && set[p[end - 1]]) {
+		end--;
+	}
+	return string_slice(s, start, end - start);
+}
+
+/* Inserts new before every character of s and at its end. */
+static struct string interleave(struct string s, struct string new)
+{
+	const unsigned char *p = (const unsigned char *) string_buffer(s);
+	size_t length = string_length(s);
+	size_t count = 1;
+	struct string result;
+	char *out = NULL;
+
+	for (size_t i = 0; i < length; i++) {
+		/* UTF-8 continuation bytes do not start a character. */
+		count += (p[i] & 0xc0) != 0x80;
+	}
+	if (!(result = string_alloc(length +
+				    count * string_length(new))).valid) {
+		return NULL_STRING;
+	}
+	out = string_buffer(result);
+
+	for (size_t i = 0; i < length; i++) {
+		if ((p[i] & 0xc0) != 0x80) {
+			memcpy(out, string_buffer(new), string_length(new));
+			out += string_length(new);
+		}
+		*out++ = (char) p[i];
+	}
+	memcpy(out, string_buffer(new), string_length(new));
+
+	return result;
+}
+
+struct string string_replace(struct string s, struct string old,
+			     struct string new)
+{
+	const char *p = string_buffer(s);
+	const char *end = p + string_length(s);
+	const char *q = NULL;
+	size_t n = string_length(old);
+	size_t count = 0;
+	struct string result;
+	char *out = NULL;
+
+	if (n == 0) {
+		return interleave(s, new);
+	}
+	if ((count = string_count(s, old)) == 0) {
+		return string_slice(s, 0, string_length(s));
+	}
+
+	result = string_alloc(string_length(s) - count * n +
+			      count * string_length(new));
+	if (!result.valid) {
+		return NULL_STRING;
+	}
+	out = string_buffer(result);
+
+	while ((q = find(p, end - p, string_buffer(old), n)) != NULL) {
+		memcpy(out, p, q - p);
+		out += q - p;
+		memcpy(out, string_buffer(new), string_length(new));
+		out += string_length(new);
+		p = q + n;
+	}
+	memcpy(out, p, end - p);
+
+	return result;
+}
+
+struct string string_join(struct string sep,
+			  const struct string *parts, size_t count)
+{
+	size_t length = 0;
+	struct string result;
+	char *out = NULL;
+
+	for (size_t i = 0; i < count; i++) {
+		length += string_length(parts[i]);
+	}
+	if (count > 1) {
+		length += (count - 1) * string_length(sep);
+	}
+
+	if (!(result = string_alloc(length)).valid) {
+		return NULL_STRING;
+	}
+	out = string_buffer(result);
+
+	for (size_t i = 0; i < count; i++) {
+		if (i > 0) {
+			memcpy(out, string_buffer(sep), string_length(sep));
+			out += string_length(sep);
+		}
+		memcpy(out, string_buffer(parts[i]), string_length(parts[i]));
+		out += string_length(parts[i]);
+	}
+
+	return result;
+}
+
+void string_split_init(struct string_split *it, struct string s,
+		       struct string sep)
+{
+	it->pos = string_buffer(s);
+	it->end = it->pos + string_length(s);
+	it->sep = string_length(sep) > 0 ? sep : NULL_STRING;
+	it->done = false;
+}
+
+bool string_split_next(struct string_split *it, struct string *part)
+{
+	const char *p = it->pos;
+	const char *q = NULL;
+
+	if (it->done) {
+		return false;
+	}
+
+	if (string_is_null(it->sep)) {
+		while (p < it->end && isspace((unsigned char) *p)) {
+			p++;
+		}
+		if (p == it->end) {
+			it->done = true;
+			return false;
+		}
+		q = p;
+		while (q < it->end && !isspace((unsigned char) *q)) {
+			q++;
+		}
+		it->pos = q;
+	} else {
+		q = find(p, it->end - p,
+			 string_buffer(it->sep), string_length(it->sep));
+		if (q == NULL) {
+			q = it->end;
+			it->done = true;
+		} else {
+			it->pos = q + string_length(it->sep);
+		}
+	}
+
+	*part = string_from_buf_n(p, q - p);
+	return true;
+}
@@ -26,6 +26,7 @@
 #define COMMON_H
 
 #include "defs.h"
+#include "ast.h"
 
 struct string_data {
 	char *buffer;
@@ -71,8 +72,107 @@ static inline const char *string_text(struct string s)
 	return string_buffer(s);
 }
 
-void *mem_alloc(size_t size);
-void  mem_free(void *ptr, size_t size);
+/*
+ * String operations.
+ *
+ * Results that are substrings of the argument are returned as raw
+ * views into it, without copying; they stay valid as long as the
+ * argument does.  Every result may still be passed to string_free().
+ */
+
+struct string string_slice(struct string s, size_t start, size_t length);
+bool          string_find(struct string s, struct string needle, size_t *pos);
+bool          string_contains(struct string s, struct string needle);
+bool          string_startswith(struct string s, struct string prefix);
+bool          string_endswith(struct string s, struct string suffix);
+size_t        string_count(struct string s, struct string needle);
+
+/**
+ * \brief Strip leading and trailing characters
+ *
+ * Strips any of the bytes in chars, or whitespace if chars is null.
+ */
+struct string string_strip(struct string s, struct string chars);
+
+/**
+ * \brief Replace all occurrences of old with new
+ *
+ * Like Python's str.replace(), an empty old matches before every
+ * character and at the end, so new is inserted around each character;
+ * characters are UTF-8 sequences.  Returns a view of s when there is
+ * nothing to replace.
+ */
+struct string string_replace(struct string s, struct string old,
+			     struct string new);
+
+struct string string_join(struct string sep,
+			  const struct string *parts, size_t count);
+
+struct string_split {
+	const char *pos;
+	const char *end;
+	struct string sep;
+	bool done;
+};
+
+/**
+ * \brief Split iterator
+ *
+ * With a null or empty separator splits on runs of whitespace and skips
+ * empty parts, otherwise keeps them.  Parts are views into s.
+ */
+void string_split_init(struct string_split *it, struct string s,
+		       struct string sep);
+bool string_split_next(struct string_split *it, struct string *part);
+
+/*
+ * Allocation tags.  Tags only matter when the library is built with
+ * MEM_STATS=1, see memstats.h.  AST nodes are tagged by node type with
+ * MEM_AST_TAG(), the other tags are listed here.
+ */
+#define MEM_TAG_MAP(X)	\
+	X(OTHER)	\
+	X(LEXER)	\
+	X(STRING)	\
+	X(TRACE)	\
+	X(FORMAT)	\
+	X(ATOM)		\
+	X(PATH)		\
+	X(ARGS)		\
+	X(STRBUF)	\
+	X(CONFIG)	\
+	X(COMMAND)	\
+	X(FS)		\
+	X(PKGCONFIG)	\
+	X(TOOLCHAIN)	\
+	X(LSP)
+
+enum mem_tag {
+#define GEN(N) MEM_##N,
+	MEM_TAG_MAP(GEN)
+#undef GEN
+#define GEN(N) MEM_AST_##N,
+	AST_TYPE_MAP(GEN)
+#undef GEN
+	MEM_TAG_COUNT
+};
+
+#define MEM_AST_TAG(type) ((enum mem_tag) (MEM_AST_EMPTY + (type)))
+
+void *mem_alloc_tag(size_t size, enum mem_tag tag);
+void *mem_realloc_tag(void *ptr, size_t old_size, size_t size,
+		      enum mem_tag tag);
+void  mem_free_tag(void *ptr, size_t size, enum mem_tag tag);
+
+static inline void *mem_alloc(size_t size)
+{
+	return mem_alloc_tag(size, MEM_OTHER);
+}
+
+static inline void mem_free(void *ptr, size_t size)
+{
+	mem_free_tag(ptr, size, MEM_OTHER);
+}
 
 #define ALLOC_SIZEOF(expr) mem_alloc(sizeof(expr))
 
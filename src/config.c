@@ -0,0 +1,298 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "config.h"
+#include "atom.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_CAPACITY 64
+
+static uint32_t hash_name(struct string name)
+{
+	return atom_hash(string_buffer(name), string_length(name));
+}
+
+void config_data_init(struct config_data *cd)
+{
+	memset(cd, 0, sizeof(*cd));
+}
+
+static void free_entry(struct config_entry *e)
+{
+	string_free(&e->name);
+	string_free(&e->value);
+	string_free(&e->description);
+}
+
+void config_data_free(struct config_data *cd)
+{
+	for (size_t i = 0; i < cd->count; i++) {
+		free_entry(&cd->entries[i]);
+	}
+	if (cd->entries != NULL) {
+		mem_free_tag(cd->entries, cd->capacity * sizeof(*cd->entries),
+			     MEM_CONFIG);
+	}
+	if (cd->slots != NULL) {
+		mem_free_tag(cd->slots, cd->slots_capacity * sizeof(*cd->slots),
+			     MEM_CONFIG);
+	}
+	memset(cd, 0, sizeof(*cd));
+}
+
+/* Returns the slot holding name, or the free slot where it belongs. */
+static uint32_t *probe(const struct config_data *cd, uint32_t *slots,
+		       size_t capacity, struct string name)
+{
+	size_t mask = capacity - 1;
+	size_t i = hash_name(name) & mask;
+
+	while (slots[i] != 0 &&
+	       !string_equal(cd->entries[slots[i] - 1].name, name)) {
+		i = (i + 1) & mask;
+	}
+	return &slots[i];
+}
+
+static bool grow(struct config_data *cd)
+{
+	size_t capacity = cd->capacity ? cd->capacity * 2 : INITIAL_CAPACITY;
+	struct config_entry *entries = NULL;
+	uint32_t *slots = NULL;
+
+	if ((slots = mem_alloc_tag(2 * capacity * sizeof(*slots),
+				   MEM_CONFIG)) == NULL) {
+		return false;
+	}
+	if ((entries = mem_realloc_tag(cd->entries,
+				       cd->capacity * sizeof(*entries),
+				       capacity * sizeof(*entries),
+				       MEM_CONFIG)) == NULL) {
+		mem_free_tag(slots, 2 * capacity * sizeof(*slots), MEM_CONFIG);
+		return false;
+	}
+	cd->entries = entries;
+	cd->capacity = capacity;
+
+	for (size_t i = 0; i < cd->count; i++) {
+		*probe(cd, slots, 2 * capacity, entries[i].name) = i + 1;
+	}
+	if (cd->slots != NULL) {
+		mem_free_tag(cd->slots, cd->slots_capacity * sizeof(*cd->slots),
+			     MEM_CONFIG);
+	}
+	cd->slots = slots;
+	cd->slots_capacity = 2 * capacity;
+
+	return true;
+}
+
+const struct config_entry *config_data_get(const struct config_data *cd,
+					   struct string name)
+{
+	uint32_t index = 0;
+
+	if (cd->count == 0) {
+		return NULL;
+	}
+	index = *probe(cd, cd->slots, cd->slots_capacity, name);
+	return index != 0 ? &cd->entries[index - 1] : NULL;
+}
+
+/* Takes ownership of value, which must not be null. */
+static bool set(struct config_data *cd, struct string name,
+		struct string value, struct string description,
+		enum config_kind kind)
+{
+	struct config_entry e = { .kind = kind, .value = value };
+	uint32_t *slot = NULL;
+
+	if (!value.valid) {
+		return false;
+	}
+	if (!string_is_null(description) &&
+	    !(e.description = string_dup_n(string_buffer(description),
+					   string_length(description))).valid) {
+		goto fail;
+	}
+
+	if (cd->count > 0) {
+		slot = probe(cd, cd->slots, cd->slots_capacity, name);
+		if (*slot != 0) {
+			struct config_entry *old = &cd->entries[*slot - 1];
+
+			e.name = old->name;
+			old->name = NULL_STRING;
+			free_entry(old);
+			*old = e;
+			return true;
+		}
+	}
+
+	if (cd->count == cd->capacity) {
+		if (!grow(cd)) {
+			goto fail;
+		}
+	}
+	if (!(e.name = string_dup_n(string_buffer(name),
+				    string_length(name))).valid) {
+		goto fail;
+	}
+	*probe(cd, cd->slots, cd->slots_capacity, name) = cd->count + 1;
+	cd->entries[cd->count++] = e;
+
+	return true;
+fail:
+	free_entry(&e);
+	return false;
+}
+
+bool config_data_set(struct config_data *cd, struct string name,
+		     struct string value, struct string description)
+{
+	return set(cd, name, string_dup_n(string_buffer(value),
+					  string_length(value)),
+		   description, CONFIG_DEFINE);
+}
+
+bool config_data_set_quoted(struct config_data *cd, struct string name,
+			    struct string value, struct string description)
+{
+	const char *p = string_buffer(value);
+	size_t length = string_length(value) + 2;
+	struct string quoted;
+	char *out = NULL;
+
+	for (size_t i = 0; i < string_length(value); i++) {
+		length += p[i] == '"' || p[i] == '\\';
+	}
+	if ((quoted = string_alloc(length)).valid) {
+		out = string_buffer(quoted);
+		*out++ = '"';
+		for (size_t i = 0; i < string_length(value); i++) {
+			if (p[i] == '"' || p[i] == '\\') {
+				*out++ = '\\';
+			}
+			*out++ = p[i];
+		}
+		*out = '"';
+	}
+	return set(cd, name, quoted, description, CONFIG_DEFINE);
+}
+
+bool config_data_set_bool(struct config_data *cd, struct string name,
+			  bool value, struct string description)
+{
+	return set(cd, name, CSTRING(""), description,
+		   value ? CONFIG_DEFINE : CONFIG_UNDEF);
+}
+
+bool config_data_set_number(struct config_data *cd, struct string name,
+			    int64_t value, struct string description)
+{
+	char buffer[24];
+	int n = snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+
+	return set(cd, name, string_dup_n(buffer, n), description,
+		   CONFIG_DEFINE);
+}
+
+static int compare_names(const void *a, const void *b)
+{
+	const struct config_entry *x = *(const struct config_entry *const *) a;
+	const struct config_entry *y = *(const struct config_entry *const *) b;
+	size_t lx = string_length(x->name);
+	size_t ly = string_length(y->name);
+	int r = memcmp(string_buffer(x->name), string_buffer(y->name),
+		       lx < ly ? lx : ly);
+
+	return r != 0 ? r : (lx > ly) - (lx < ly);
+}
+
+void config_header_render(const struct config_data *cd, struct strbuf *out)
+{
+	const struct config_entry **sorted = NULL;
+
+	strbuf_append(out, CSTRING(
+		"/*\n"
+		" * Autogenerated by the Meson build system.\n"
+		" * Do not edit, your changes will be lost.\n"
+		" */\n"
+		"\n"
+		"#pragma once\n"
+		"\n"));
+
+	if (cd->count == 0) {
+		return;
+	}
+	if ((sorted = mem_alloc_tag(cd->count * sizeof(*sorted),
+				    MEM_CONFIG)) == NULL) {
+		out->failed = true;
+		return;
+	}
+	for (size_t i = 0; i < cd->count; i++) {
+		sorted[i] = &cd->entries[i];
+	}
+	qsort(sorted, cd->count, sizeof(*sorted), compare_names);
+
+	for (size_t i = 0; i < cd->count; i++) {
+		const struct config_entry *e = sorted[i];
+
+		if (!string_is_null(e->description)) {
+			strbuf_append(out, CSTRING("/* "));
+			strbuf_append(out, e->description);
+			strbuf_append(out, CSTRING(" */\n"));
+		}
+		if (e->kind == CONFIG_UNDEF) {
+			strbuf_append(out, CSTRING("#undef "));
+			strbuf_append(out, e->name);
+		} else {
+			strbuf_append(out, CSTRING("#define "));
+			strbuf_append(out, e->name);
+			if (string_length(e->value) > 0) {
+				strbuf_putc(out, ' ');
+				strbuf_append(out, e->value);
+			}
+		}
+		strbuf_append(out, CSTRING("\n\n"));
+	}
+
+	mem_free_tag(sorted, cd->count * sizeof(*sorted), MEM_CONFIG);
+}
+
+bool config_header_write(const struct config_data *cd, const char *path,
+			 bool *changed)
+{
+	struct strbuf out;
+	bool ok = false;
+
+	strbuf_init(&out);
+	config_header_render(cd, &out);
+	ok = strbuf_write_if_changed(&out, path, changed);
+	strbuf_free(&out);
+
+	return ok;
+}
@@ -0,0 +1,97 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include "strbuf.h"
+
+/*
+ * configuration_data() and the C header generated from it.
+ *
+ * Entries are kept in an insertion-ordered hash table.  The header
+ * lists them sorted by name, so its contents depend only on the final
+ * set of entries and not on the order of set() calls.
+ */
+
+enum config_kind {
+	/* #define NAME VALUE, VALUE may be empty */
+	CONFIG_DEFINE,
+	/* #undef NAME */
+	CONFIG_UNDEF
+};
+
+struct config_entry {
+	struct string name;
+	struct string value;
+	/* Null if there is none */
+	struct string description;
+	enum config_kind kind;
+};
+
+struct config_data {
+	/* In insertion order */
+	struct config_entry *entries;
+	size_t count;
+	size_t capacity;
+	/* Entry index plus one, 0 for free slots */
+	uint32_t *slots;
+	size_t slots_capacity;
+};
+
+void config_data_init(struct config_data *cd);
+void config_data_free(struct config_data *cd);
+
+/*
+ * Setters copy their arguments.  Setting an existing name replaces its
+ * value and description but keeps its position.  They return false on
+ * allocation failure, leaving the entry as it was.
+ */
+
+bool config_data_set(struct config_data *cd, struct string name,
+		     struct string value, struct string description);
+bool config_data_set_quoted(struct config_data *cd, struct string name,
+			    struct string value, struct string description);
+bool config_data_set_bool(struct config_data *cd, struct string name,
+			  bool value, struct string description);
+bool config_data_set_number(struct config_data *cd, struct string name,
+			    int64_t value, struct string description);
+
+const struct config_entry *config_data_get(const struct config_data *cd,
+					   struct string name);
+
+/**
+ * \brief Append the header text to out
+ */
+void config_header_render(const struct config_data *cd, struct strbuf *out);
+
+/**
+ * \brief Write the header unless the file already has this content
+ *
+ * See strbuf_write_if_changed().
+ */
+bool config_header_write(const struct config_data *cd, const char *path,
+			 bool *changed);
+
+#endif /* CONFIG_H */
@@ -0,0 +1,195 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "format.h"
+#include "common.h"
+
+/*
+ * Matches a placeholder `@N@' at p, returns its length or 0.  Indices
+ * too large to be valid saturate, so formatting reports them as out of
+ * range.
+ */
+static size_t placeholder(const char *p, const char *end, uint32_t *arg)
+{
+	const char *q = p + 1;
+	uint64_t n = 0;
+
+	while (q < end && *q >= '0' && *q <= '9') {
+		if ((n = n * 10 + (*q - '0')) >= FORMAT_LITERAL) {
+			n = FORMAT_LITERAL - 1;
+		}
+		q++;
+	}
+	if (q == p + 1 || q == end || *q != '@') {
+		return 0;
+	}
+	*arg = (uint32_t) n;
+	return q + 1 - p;
+}
+
+/*
+ * Calls emit() for every segment in order.  Literal runs are kept whole,
+ * an `@' that does not start a placeholder simply extends the run.
+ */
+static void scan(struct string template,
+		 void (*emit)(void *ctx, uint32_t arg, const char *text,
+			      size_t length),
+		 void *ctx)
+{
+	const char *p = string_buffer(template);
+	const char *end = p + string_length(template);
+	const char *lit = p;
+
+	while ((p = memchr(p, '@', end - p)) != NULL) {
+		uint32_t arg = 0;
+		size_t n = 0;
+
+		if ((n = placeholder(p, end, &arg)) == 0) {
+			p++;
+			continue;
+		}
+		if (p > lit) {
+			emit(ctx, FORMAT_LITERAL, lit, p - lit);
+		}
+		emit(ctx, arg, NULL, 0);
+		lit = p += n;
+	}
+	if (end > lit) {
+		emit(ctx, FORMAT_LITERAL, lit, end - lit);
+	}
+}
+
+static void measure(void *ctx, uint32_t arg, const char *text, size_t length)
+{
+	struct format *f = ctx;
+
+	UNUSED(text);
+	f->count++;
+	if (arg == FORMAT_LITERAL) {
+		f->literal_length += length;
+	} else if (arg >= f->args) {
+		f->args = arg + 1;
+	}
+}
+
+struct fill {
+	struct format *f;
+	/* Next free byte of the literal text after the segments */
+	char *text;
+};
+
+static void fill(void *ctx, uint32_t arg, const char *text, size_t length)
+{
+	struct fill *state = ctx;
+	struct format_segment *seg = &state->f->segments[state->f->count++];
+
+	seg->arg = arg;
+	if (arg == FORMAT_LITERAL) {
+		seg->text = memcpy(state->text, text, length);
+		seg->length = length;
+		state->text += length;
+	}
+}
+
+struct format *format_compile(struct string template)
+{
+	struct format counts = { 0 };
+	struct fill state = { NULL, NULL };
+	size_t size = 0;
+
+	if (string_length(template) > 0) {
+		scan(template, measure, &counts);
+	}
+
+	size = sizeof(*state.f) + counts.count * sizeof(state.f->segments[0]) +
+		counts.literal_length;
+	if ((state.f = mem_alloc_tag(size, MEM_FORMAT)) == NULL) {
+		return NULL;
+	}
+	state.f->size = size;
+	state.f->literal_length = counts.literal_length;
+	state.f->args = counts.args;
+	state.text = (char *) &state.f->segments[counts.count];
+
+	if (counts.count > 0) {
+		scan(template, fill, &state);
+	}
+
+	return state.f;
+}
+
+struct format *format_compile_ast(struct ast *ast)
+{
+	struct ast_string *s = NULL;
+
+	if ((s = ast_as(ast, AST_STRING)) == NULL) {
+		return NULL;
+	}
+	return format_compile(s->value);
+}
+
+void format_free(struct format *f)
+{
+	if (f != NULL) {
+		mem_free_tag(f, f->size, MEM_FORMAT);
+	}
+}
+
+struct string format_apply(const struct format *f,
+			   const struct string *args, size_t count)
+{
+	const struct format_segment *seg = f->segments;
+	const struct format_segment *end = seg + f->count;
+	size_t length = f->literal_length;
+	struct string result;
+	char *out = NULL;
+
+	if (f->args > count) {
+		return NULL_STRING;
+	}
+	for (; seg < end; seg++) {
+		if (seg->arg != FORMAT_LITERAL) {
+			length += string_length(args[seg->arg]);
+		}
+	}
+
+	if (!(result = string_alloc(length)).valid) {
+		return NULL_STRING;
+	}
+	out = string_buffer(result);
+
+	for (seg = f->segments; seg < end; seg++) {
+		if (seg->arg == FORMAT_LITERAL) {
+			memcpy(out, seg->text, seg->length);
+			out += seg->length;
+		} else {
+			struct string arg = args[seg->arg];
+
+			memcpy(out, string_buffer(arg), string_length(arg));
+			out += string_length(arg);
+		}
+	}
+
+	return result;
+}
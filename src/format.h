@@ -0,0 +1,85 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include "ast.h"
+
+/*
+ * Precompiled format templates for str.format().
+ *
+ * A template such as '@0@/@1@' is scanned once into a list of literal
+ * and placeholder segments.  Formatting then sizes the result from the
+ * segment lengths, allocates it once and copies each segment in, without
+ * looking at the template text again.
+ */
+
+#define FORMAT_LITERAL UINT32_MAX
+
+struct format_segment {
+	/* Argument index, or FORMAT_LITERAL */
+	uint32_t arg;
+	uint32_t length;
+	const char *text;
+};
+
+struct format {
+	size_t size;
+	size_t count;
+	/* Total length of the literal segments */
+	size_t literal_length;
+	/* One more than the highest placeholder index, 0 if none */
+	size_t args;
+	struct format_segment segments[];
+};
+
+/**
+ * \brief Compile a template
+ *
+ * Literal text is copied into the returned object, so the template need
+ * not outlive it.  '@' not forming a placeholder is kept as is.
+ */
+struct format *format_compile(struct string template);
+
+/**
+ * \brief Compile the template of a string literal
+ *
+ * Returns null if ast is not a string literal.
+ */
+struct format *format_compile_ast(struct ast *ast);
+
+void format_free(struct format *f);
+
+/**
+ * \brief Format arguments
+ *
+ * Returns a null string if the template refers to an argument past
+ * count or on allocation failure; check count against f->args to tell
+ * the two apart.
+ */
+struct string format_apply(const struct format *f,
+			   const struct string *args, size_t count);
+
+#endif /* FORMAT_H */
@@ -0,0 +1,440 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "fs.h"
+#include "atom.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INITIAL_CAPACITY 64
+
+/*
+ * Regular files at least this large are mapped, smaller ones and other
+ * files are copied.
+ */
+#define MAP_THRESHOLD (64 * 1024)
+
+#ifdef __APPLE__
+#define MTIME_NSEC(st) ((st).st_mtimespec.tv_nsec)
+#else
+#define MTIME_NSEC(st) ((st).st_mtim.tv_nsec)
+#endif
+
+struct fs_entry {
+	uint32_t hash;
+	struct fs_stat st;
+	/* Contents read by fs_read(), mapped or in a buffer of capacity */
+	bool loaded;
+	bool mapped;
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+	/* Terminated, for system calls */
+	size_t length;
+	char path[];
+};
+
+static size_t entry_size(const struct fs_entry *e)
+{
+	return sizeof(*e) + e->length + 1;
+}
+
+void fs_cache_init(struct fs_cache *c)
+{
+	memset(c, 0, sizeof(*c));
+}
+
+void fs_cache_free(struct fs_cache *c)
+{
+	for (size_t i = 0; i < c->count; i++) {
+		struct fs_entry *e = c->entries[i];
+
+		if (e->mapped) {
+			munmap(e->data, e->data_size);
+		} else if (e->data != NULL) {
+			mem_free_tag(e->data, e->data_capacity, MEM_FS);
+		}
+		mem_free_tag(e, entry_size(e), MEM_FS);
+	}
+	if (c->entries != NULL) {
+		mem_free_tag(c->entries,
+			     c->entries_capacity * sizeof(*c->entries), MEM_FS);
+	}
+	if (c->slots != NULL) {
+		mem_free_tag(c->slots, c->capacity * sizeof(*c->slots), MEM_FS);
+	}
+	memset(c, 0, sizeof(*c));
+}
+
+void fs_stat_path(const char *path, struct fs_stat *st)
+{
+	struct stat s;
+
+	memset(st, 0, sizeof(*st));
+	if (lstat(path, &s) == 0 && S_ISLNK(s.st_mode)) {
+		st->is_symlink = true;
+	}
+	if (stat(path, &s) != 0) {
+		return;
+	}
+	st->exists = true;
+	st->is_dir = S_ISDIR(s.st_mode);
+	st->is_file = S_ISREG(s.st_mode);
+	st->size = s.st_size;
+	st->mtime = (int64_t) s.st_mtime * 1000000000 + MTIME_NSEC(s);
+	st->ino = s.st_ino;
+}
+
+static bool stat_equal(const struct fs_stat *a, const struct fs_stat *b)
+{
+	return a->exists == b->exists && a->is_dir == b->is_dir &&
+		a->is_file == b->is_file && a->is_symlink == b->is_symlink &&
+		a->size == b->size && a->mtime == b->mtime && a->ino == b->ino;
+}
+
+static struct fs_entry **probe(struct fs_entry **slots, size_t capacity,
+			       uint32_t hash, struct string path)
+{
+	size_t mask = capacity - 1;
+	size_t i = hash & mask;
+
+	while (slots[i] != NULL &&
+	       (slots[i]->hash != hash ||
+		slots[i]->length != string_length(path) ||
+		memcmp(slots[i]->path, string_buffer(path),
+		       string_length(path)) != 0)) {
+		i = (i + 1) & mask;
+	}
+	return &slots[i];
+}
+
+static bool grow(struct fs_cache *c)
+{
+	size_t capacity = c->capacity ? c->capacity * 2 : INITIAL_CAPACITY;
+	struct fs_entry **slots = NULL;
+	struct fs_entry **entries = NULL;
+
+	if ((slots = mem_alloc_tag(capacity * sizeof(*slots), MEM_FS)) == NULL) {
+		return false;
+	}
+	/* At most 3/4 of the slots are used. */
+	if ((entries = mem_realloc_tag(c->entries,
+				       c->entries_capacity * sizeof(*entries),
+				       capacity * 3 / 4 * sizeof(*entries),
+				       MEM_FS)) == NULL) {
+		mem_free_tag(slots, capacity * sizeof(*slots), MEM_FS);
+		return false;
+	}
+	c->entries = entries;
+	c->entries_capacity = capacity * 3 / 4;
+
+	for (size_t i = 0; i < c->count; i++) {
+		struct fs_entry *e = entries[i];
+
+		*probe(slots, capacity, e->hash,
+		       string_from_buf_n(e->path, e->length)) = e;
+	}
+	if (c->slots != NULL) {
+		mem_free_tag(c->slots, c->capacity * sizeof(*c->slots), MEM_FS);
+	}
+	c->slots = slots;
+	c->capacity = capacity;
+
+	return true;
+}
+
+static struct fs_entry *lookup(struct fs_cache *c, struct string path)
+{
+	uint32_t hash = atom_hash(string_buffer(path), string_length(path));
+	struct fs_entry **slot = NULL;
+	struct fs_entry *e = NULL;
+
+	if (c->capacity > 0) {
+		slot = probe(c->slots, c->capacity, hash, path);
+		if (*slot != NULL) {
+			return *slot;
+		}
+	}
+	if (c->count == c->entries_capacity) {
+		if (!grow(c)) {
+			return NULL;
+		}
+		slot = probe(c->slots, c->capacity, hash, path);
+	}
+
+	if ((e = mem_alloc_tag(sizeof(*e) + string_length(path) + 1,
+			       MEM_FS)) == NULL) {
+		return NULL;
+	}
+	e->hash = hash;
+	e->length = string_length(path);
+	memcpy(e->path, string_buffer(path), e->length);
+	e->path[e->length] = '\0';
+	fs_stat_path(e->path, &e->st);
+
+	c->entries[c->count++] = e;
+	return *slot = e;
+}
+
+const struct fs_stat *fs_stat(struct fs_cache *c, struct string path)
+{
+	struct fs_entry *e = lookup(c, path);
+
+	return e != NULL ? &e->st : NULL;
+}
+
+bool fs_exists(struct fs_cache *c, struct string path)
+{
+	const struct fs_stat *st = fs_stat(c, path);
+
+	return st != NULL && st->exists;
+}
+
+bool fs_is_dir(struct fs_cache *c, struct string path)
+{
+	const struct fs_stat *st = fs_stat(c, path);
+
+	return st != NULL && st->is_dir;
+}
+
+bool fs_is_file(struct fs_cache *c, struct string path)
+{
+	const struct fs_stat *st = fs_stat(c, path);
+
+	return st != NULL && st->is_file;
+}
+
+bool fs_is_symlink(struct fs_cache *c, struct string path)
+{
+	const struct fs_stat *st = fs_stat(c, path);
+
+	return st != NULL && st->is_symlink;
+}
+
+/* Reads fd to its end, the size is only a hint. */
+static bool copy(struct fs_entry *e, int fd, size_t size)
+{
+	size_t capacity = size + 1 > 4096 ? size + 1 : 4096;
+	size_t length = 0;
+	char *data = NULL;
+	char *p = NULL;
+	ssize_t n = 0;
+
+	if ((data = mem_alloc_tag(capacity, MEM_FS)) == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+	while ((n = read(fd, data + length, capacity - length)) != 0) {
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			goto fail;
+		}
+		if ((length += n) < capacity) {
+			continue;
+		}
+		if ((p = mem_realloc_tag(data, capacity, 2 * capacity,
+					 MEM_FS)) == NULL) {
+			errno = ENOMEM;
+			goto fail;
+		}
+		data = p;
+		capacity *= 2;
+	}
+	e->data = data;
+	e->data_size = length;
+	e->data_capacity = capacity;
+	return true;
+fail:
+	mem_free_tag(data, capacity, MEM_FS);
+	return false;
+}
+
+/*
+ * Sizes come from the open file rather than the cached metadata, which
+ * may be stale, and files that report no size (/proc, pipes) are read
+ * to their end.
+ */
+static bool load(struct fs_entry *e)
+{
+	struct stat s;
+	void *p = NULL;
+	int fd = -1;
+	int saved = 0;
+
+	if ((fd = open(e->path, O_RDONLY)) < 0) {
+		return false;
+	}
+	if (fstat(fd, &s) != 0) {
+		goto fail;
+	}
+	if (S_ISREG(s.st_mode) && s.st_size >= MAP_THRESHOLD) {
+		p = mmap(NULL, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			goto fail;
+		}
+		e->data = p;
+		e->data_size = s.st_size;
+		e->mapped = true;
+	} else if (!copy(e, fd, S_ISREG(s.st_mode) ? s.st_size : 0)) {
+		goto fail;
+	}
+	close(fd);
+	e->loaded = true;
+	return true;
+fail:
+	saved = errno;
+	close(fd);
+	errno = saved;
+	return false;
+}
+
+bool fs_read(struct fs_cache *c, struct string path, struct string *contents)
+{
+	struct fs_entry *e = NULL;
+
+	if ((e = lookup(c, path)) == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+	if (!e->st.exists) {
+		errno = ENOENT;
+		return false;
+	}
+	if (e->st.is_dir) {
+		errno = EISDIR;
+		return false;
+	}
+	if (!e->loaded && !load(e)) {
+		return false;
+	}
+	*contents = string_from_buf_n(e->data, e->data_size);
+
+	return true;
+}
+
+bool fs_hash(struct fs_cache *c, struct string path,
+	     enum hash_algorithm algorithm, char hex[2 * HASH_MAX_SIZE + 1])
+{
+	uint8_t digest[HASH_MAX_SIZE];
+	struct string contents;
+	size_t size = 0;
+
+	if (!fs_read(c, path, &contents)) {
+		return false;
+	}
+	size = hash_digest(algorithm, string_buffer(contents),
+			   string_length(contents), digest);
+	hash_hex(digest, size, hex);
+
+	return true;
+}
+
+static unsigned int flags(const struct fs_stat *st)
+{
+	return st->exists | st->is_dir << 1 | st->is_file << 2 |
+		st->is_symlink << 3;
+}
+
+void fs_inputs_write(const struct fs_cache *c, struct strbuf *out)
+{
+	for (size_t i = 0; i < c->count; i++) {
+		const struct fs_entry *e = c->entries[i];
+
+		strbuf_printf(out, "%u %" PRIu64 " %" PRId64 " %" PRIu64 " ",
+			      flags(&e->st), e->st.size, e->st.mtime,
+			      e->st.ino);
+		strbuf_append_n(out, e->path, e->length);
+		strbuf_putc(out, '\n');
+	}
+}
+
+static bool parse_number(const char **p, const char *end, bool sign,
+			 uint64_t *value)
+{
+	bool negative = sign && *p < end && **p == '-';
+	const char *q = *p + negative;
+	uint64_t n = 0;
+
+	if (q == end || *q < '0' || *q > '9') {
+		return false;
+	}
+	for (; q < end && *q >= '0' && *q <= '9'; q++) {
+		n = n * 10 + (*q - '0');
+	}
+	if (q == end || *q != ' ') {
+		return false;
+	}
+	*value = negative ? -n : n;
+	*p = q + 1;
+	return true;
+}
+
+bool fs_inputs_check(struct string record, bool *changed)
+{
+	struct string_split it;
+	struct string line;
+
+	*changed = false;
+	string_split_init(&it, record, CSTRING("\n"));
+	while (!*changed && string_split_next(&it, &line)) {
+		const char *p = string_buffer(line);
+		const char *end = p + string_length(line);
+		struct fs_stat recorded = { 0 };
+		struct fs_stat current;
+		uint64_t f = 0;
+		uint64_t mtime = 0;
+		struct string path;
+
+		if (string_length(line) == 0) {
+			continue;
+		}
+		if (!parse_number(&p, end, false, &f) ||
+		    !parse_number(&p, end, false, &recorded.size) ||
+		    !parse_number(&p, end, true, &mtime) ||
+		    !parse_number(&p, end, false, &recorded.ino) ||
+		    p == end) {
+			return false;
+		}
+		recorded.exists = f & 1;
+		recorded.is_dir = f & 2;
+		recorded.is_file = f & 4;
+		recorded.is_symlink = f & 8;
+		recorded.mtime = (int64_t) mtime;
+
+		if (!(path = string_dup_n(p, end - p)).valid) {
+			return false;
+		}
+		fs_stat_path(string_buffer(path), &current);
+		string_free(&path);
+
+		*changed = !stat_equal(&recorded, &current);
+	}
+	return true;
+}
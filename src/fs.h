@@ -0,0 +1,114 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef FS_H
+#define FS_H
+
+#include "hash.h"
+#include "strbuf.h"
+
+/*
+ * Core of import('fs').
+ *
+ * Every path the module looks at goes through a cache that stats it
+ * once per configure run.  File contents are read once and handed out
+ * as string views that stay valid until the cache is freed.  Every
+ * path looked at is also an input of the configuration:
+ * fs_inputs_write() records them and fs_inputs_check() tells whether
+ * any of them changed since.
+ */
+
+struct fs_stat {
+	bool exists;
+	bool is_dir;
+	bool is_file;
+	bool is_symlink;
+	uint64_t size;
+	int64_t mtime;
+	uint64_t ino;
+};
+
+struct fs_entry;
+
+struct fs_cache {
+	struct fs_entry **slots;
+	size_t capacity;
+	/* Entries in the order they were first looked at */
+	struct fs_entry **entries;
+	size_t count;
+	size_t entries_capacity;
+};
+
+void fs_cache_init(struct fs_cache *c);
+void fs_cache_free(struct fs_cache *c);
+
+/**
+ * \brief Metadata of path, following symbolic links
+ *
+ * A missing file is not an error, it has exists unset.  Returns null
+ * only on allocation failure.
+ */
+const struct fs_stat *fs_stat(struct fs_cache *c, struct string path);
+
+/**
+ * \brief Metadata of path, bypassing the cache
+ */
+void fs_stat_path(const char *path, struct fs_stat *st);
+
+bool fs_exists(struct fs_cache *c, struct string path);
+bool fs_is_dir(struct fs_cache *c, struct string path);
+bool fs_is_file(struct fs_cache *c, struct string path);
+bool fs_is_symlink(struct fs_cache *c, struct string path);
+
+/**
+ * \brief Contents of a file, read once
+ *
+ * Large regular files are mapped rather than copied.  Truncating such
+ * a file while the cache is alive makes accessing the lost part raise
+ * SIGBUS; files of the configuration are not expected to change during
+ * a configure run.  Returns false with errno set on failure.
+ */
+bool fs_read(struct fs_cache *c, struct string path, struct string *contents);
+
+/**
+ * \brief Hex digest of a file, as fs.hash() returns
+ *
+ * Returns false with errno set on failure.
+ */
+bool fs_hash(struct fs_cache *c, struct string path,
+	     enum hash_algorithm algorithm, char hex[2 * HASH_MAX_SIZE + 1]);
+
+/**
+ * \brief Record the metadata of every path looked at, one per line
+ */
+void fs_inputs_write(const struct fs_cache *c, struct strbuf *out);
+
+/**
+ * \brief Compare a record made by fs_inputs_write() with the file system
+ *
+ * Returns false if the record cannot be parsed.
+ */
+bool fs_inputs_check(struct string record, bool *changed);
+
+#endif /* FS_H */
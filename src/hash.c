@@ -0,0 +1,366 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "hash.h"
+#include <stdlib.h>
+
+static uint64_t read64le(const uint8_t *p)
+{
+	return (uint64_t) p[0] | (uint64_t) p[1] << 8 |
+		(uint64_t) p[2] << 16 | (uint64_t) p[3] << 24 |
+		(uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 |
+		(uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
+}
+
+static uint32_t read32le(const uint8_t *p)
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8 |
+		(uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static uint32_t read32be(const uint8_t *p)
+{
+	return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 |
+		(uint32_t) p[2] << 8 | (uint32_t) p[3];
+}
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+static uint32_t rotl32(uint32_t x, int r)
+{
+	return (x << r) | (x >> (32 - r));
+}
+
+static uint32_t rotr32(uint32_t x, int r)
+{
+	return (x >> r) | (x << (32 - r));
+}
+
+/* XXH64 */
+
+#define P1 0x9E3779B185EBCA87ull
+#define P2 0xC2B2AE3D27D4EB4Full
+#define P3 0x165667B19E3779F9ull
+#define P4 0x85EBCA77C2B2AE63ull
+#define P5 0x27D4EB2F165667C5ull
+
+static uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+	return rotl64(acc + input * P2, 31) * P1;
+}
+
+static uint64_t xxh_merge(uint64_t acc, uint64_t value)
+{
+	return (acc ^ xxh_round(0, value)) * P1 + P4;
+}
+
+uint64_t hash_xxh64(const void *data, size_t length, uint64_t seed)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = p + length;
+	uint64_t h = 0;
+
+	if (length >= 32) {
+		uint64_t v1 = seed + P1 + P2;
+		uint64_t v2 = seed + P2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - P1;
+
+		for (; end - p >= 32; p += 32) {
+			v1 = xxh_round(v1, read64le(p));
+			v2 = xxh_round(v2, read64le(p + 8));
+			v3 = xxh_round(v3, read64le(p + 16));
+			v4 = xxh_round(v4, read64le(p + 24));
+		}
+		h = rotl64(v1, 1) + rotl64(v2, 7) +
+			rotl64(v3, 12) + rotl64(v4, 18);
+		h = xxh_merge(h, v1);
+		h = xxh_merge(h, v2);
+		h = xxh_merge(h, v3);
+		h = xxh_merge(h, v4);
+	} else {
+		h = seed + P5;
+	}
+	h += length;
+
+	for (; end - p >= 8; p += 8) {
+		h ^= xxh_round(0, read64le(p));
+		h = rotl64(h, 27) * P1 + P4;
+	}
+	if (end - p >= 4) {
+		h ^= (uint64_t) read32le(p) * P1;
+		h = rotl64(h, 23) * P2 + P3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * P5;
+		h = rotl64(h, 11) * P1;
+	}
+
+	h ^= h >> 33;
+	h *= P2;
+	h ^= h >> 29;
+	h *= P3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+/*
+ * MD5 and SHA-256 share the Merkle-Damgard padding: the message, 0x80,
+ * zeros up to 56 mod 64 and the bit length in the last 8 bytes.  The
+ * tail is padded in a local buffer of at most two blocks.
+ */
+static size_t pad(const uint8_t *tail, size_t n, uint64_t length,
+		  bool big_endian, uint8_t block[128])
+{
+	size_t size = n < 56 ? 64 : 128;
+	uint64_t bits = length * 8;
+
+	memset(block, 0, size);
+	memcpy(block, tail, n);
+	block[n] = 0x80;
+	for (int i = 0; i < 8; i++) {
+		block[big_endian ? size - 1 - i : size - 8 + i] =
+			(uint8_t) (bits >> (8 * i));
+	}
+	return size;
+}
+
+/* MD5 */
+
+static const uint32_t md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+	0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+	0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+	0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+	0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+	0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+	0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+	0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+	0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t md5_r[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static void md5_block(uint32_t s[4], const uint8_t *block)
+{
+	uint32_t m[16];
+	uint32_t a = s[0], b = s[1], c = s[2], d = s[3];
+
+	for (int i = 0; i < 16; i++) {
+		m[i] = read32le(block + 4 * i);
+	}
+	for (int i = 0; i < 64; i++) {
+		uint32_t f = 0;
+		int g = 0;
+
+		if (i < 16) {
+			f = (b & c) | (~b & d);
+			g = i;
+		} else if (i < 32) {
+			f = (d & b) | (~d & c);
+			g = (5 * i + 1) % 16;
+		} else if (i < 48) {
+			f = b ^ c ^ d;
+			g = (3 * i + 5) % 16;
+		} else {
+			f = c ^ (b | ~d);
+			g = (7 * i) % 16;
+		}
+		f += a + md5_k[i] + m[g];
+		a = d;
+		d = c;
+		c = b;
+		b += rotl32(f, md5_r[i]);
+	}
+	s[0] += a;
+	s[1] += b;
+	s[2] += c;
+	s[3] += d;
+}
+
+void hash_md5(const void *data, size_t length, uint8_t digest[16])
+{
+	uint32_t s[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+	const uint8_t *p = data;
+	uint8_t block[128];
+	size_t size = 0;
+
+	for (size_t n = length; n >= 64; n -= 64, p += 64) {
+		md5_block(s, p);
+	}
+	size = pad(p, length % 64, length, false, block);
+	for (size_t i = 0; i < size; i += 64) {
+		md5_block(s, block + i);
+	}
+	for (int i = 0; i < 16; i++) {
+		digest[i] = (uint8_t) (s[i / 4] >> (8 * (i % 4)));
+	}
+}
+
+/* SHA-256 */
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void sha256_block(uint32_t s[8], const uint8_t *block)
+{
+	uint32_t w[64];
+	uint32_t v[8];
+
+	for (int i = 0; i < 16; i++) {
+		w[i] = read32be(block + 4 * i);
+	}
+	for (int i = 16; i < 64; i++) {
+		uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^
+			(w[i - 15] >> 3);
+		uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^
+			(w[i - 2] >> 10);
+
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+	memcpy(v, s, sizeof(v));
+
+	for (int i = 0; i < 64; i++) {
+		uint32_t e = v[4];
+		uint32_t a = v[0];
+		uint32_t t1 = v[7] + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) +
+			((e & v[5]) ^ (~e & v[6])) + sha256_k[i] + w[i];
+		uint32_t t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) +
+			((a & v[1]) ^ (a & v[2]) ^ (v[1] & v[2]));
+
+		v[7] = v[6];
+		v[6] = v[5];
+		v[5] = v[4];
+		v[4] = v[3] + t1;
+		v[3] = v[2];
+		v[2] = v[1];
+		v[1] = v[0];
+		v[0] = t1 + t2;
+	}
+	for (int i = 0; i < 8; i++) {
+		s[i] += v[i];
+	}
+}
+
+void hash_sha256(const void *data, size_t length, uint8_t digest[32])
+{
+	uint32_t s[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	const uint8_t *p = data;
+	uint8_t block[128];
+	size_t size = 0;
+
+	for (size_t n = length; n >= 64; n -= 64, p += 64) {
+		sha256_block(s, p);
+	}
+	size = pad(p, length % 64, length, true, block);
+	for (size_t i = 0; i < size; i += 64) {
+		sha256_block(s, block + i);
+	}
+	for (int i = 0; i < 32; i++) {
+		digest[i] = (uint8_t) (s[i / 4] >> (24 - 8 * (i % 4)));
+	}
+}
+
+size_t hash_digest(enum hash_algorithm algorithm, const void *data,
+		   size_t length, uint8_t digest[HASH_MAX_SIZE])
+{
+	uint64_t h = 0;
+
+	switch (algorithm) {
+	case HASH_xxh64:
+		h = hash_xxh64(data, length, 0);
+		for (int i = 0; i < 8; i++) {
+			digest[i] = (uint8_t) (h >> (56 - 8 * i));
+		}
+		return 8;
+	case HASH_md5:
+		hash_md5(data, length, digest);
+		return 16;
+	case HASH_sha256:
+		hash_sha256(data, length, digest);
+		return 32;
+	default:
+		UNREACHABLE();
+	}
+}
+
+bool hash_algorithm_from_name(const char *name, size_t length,
+			      enum hash_algorithm *algorithm)
+{
+#define GEN(N) \
+	if (length == sizeof(#N) - 1 && memcmp(name, #N, length) == 0) { \
+		*algorithm = HASH_##N; \
+		return true; \
+	}
+	HASH_ALGORITHM_MAP(GEN)
+#undef GEN
+	return false;
+}
+
+void hash_hex(const uint8_t *digest, size_t size, char *hex)
+{
+	static const char digits[] = "0123456789abcdef";
+
+	for (size_t i = 0; i < size; i++) {
+		hex[2 * i] = digits[digest[i] >> 4];
+		hex[2 * i + 1] = digits[digest[i] & 0xf];
+	}
+	hex[2 * size] = '\0';
+}
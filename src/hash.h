@@ -0,0 +1,76 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include "defs.h"
+
+/*
+ * Content hashes for fs.hash().
+ *
+ * XXH64 is the fast default: it keeps four independent lanes, which
+ * lets the processor overlap the multiplications.  MD5 and SHA-256 are
+ * there for scripts that ask for them by name.
+ */
+
+#define HASH_ALGORITHM_MAP(X)	\
+	X(xxh64)		\
+	X(md5)			\
+	X(sha256)
+
+enum hash_algorithm {
+#define GEN(N) HASH_##N,
+	HASH_ALGORITHM_MAP(GEN)
+#undef GEN
+	HASH_ALGORITHM_COUNT
+};
+
+#define HASH_MAX_SIZE 32
+
+uint64_t hash_xxh64(const void *data, size_t length, uint64_t seed);
+void     hash_md5(const void *data, size_t length, uint8_t digest[16]);
+void     hash_sha256(const void *data, size_t length, uint8_t digest[32]);
+
+/**
+ * \brief Hash data with an algorithm chosen at run time
+ *
+ * The XXH64 digest is stored big-endian, so that its hex form matches
+ * the usual one.  Returns the digest size.
+ */
+size_t hash_digest(enum hash_algorithm algorithm, const void *data,
+		   size_t length, uint8_t digest[HASH_MAX_SIZE]);
+
+/**
+ * \brief Look up an algorithm by its name, as in fs.hash(file, 'md5')
+ */
+bool hash_algorithm_from_name(const char *name, size_t length,
+			      enum hash_algorithm *algorithm);
+
+/**
+ * \brief Lowercase hex form of a digest, hex must hold 2 * size + 1 bytes
+ */
+void hash_hex(const uint8_t *digest, size_t size, char *hex);
+
+#endif /* HASH_H */
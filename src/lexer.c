@@ -50,12 +50,13 @@ static bool grow(struct lexer *l)
 	}
 
 	if (l->lexeme_len >= l->lexeme_max) {
-		l->lexeme_max *= 2;
-		if ((ptr = realloc(l->lexeme, l->lexeme_max)) == NULL) {
+		if ((ptr = mem_realloc_tag(l->lexeme, l->lexeme_max,
+					   l->lexeme_max * 2, MEM_LEXER)) == NULL) {
 			l->error = true;
 			return false;
 		}
 		l->lexeme = ptr;
+		l->lexeme_max *= 2;
 	}
 	return true;
 }
@@ -318,6 +319,7 @@ static struct result do_lex(struct lexer *l)
 		}
 
 		if (is_end(l)) {
+			l->token_pos = l->input_pos;
 			return finish(l, TOKEN_END);
 		}
 
@@ -326,6 +328,7 @@ static struct result do_lex(struct lexer *l)
 		}
 
 		if (peek(l) != '#') {
+			l->token_pos = l->input_pos;
 			break;
 		}
 
@@ -380,22 +383,44 @@ void lexer_init(struct lexer *l, struct string input)
 	l->input = string_text(input);
 	l->input_len = string_length(input);
 	l->lexeme_max = 128;
-	l->lexeme = mem_alloc(l->lexeme_max);
+	l->lexeme = mem_alloc_tag(l->lexeme_max, MEM_LEXER);
 }
 
 void lexer_free(struct lexer *l)
 {
-	mem_free(l->lexeme, l->lexeme_max);
+	mem_free_tag(l->lexeme, l->lexeme_max, MEM_LEXER);
 	memset(l, 0, sizeof(*l));
 }
 
 enum token_type lex(struct lexer *l)
 {
 	struct result res;
+	enum token_type token = TOKEN_ERROR;
 
 	if ((res = do_lex(l)).success) {
-		return l->error ? TOKEN_ERROR : res.token;
+		token = l->error ? TOKEN_ERROR : res.token;
+	}
+#ifdef ENABLE_TRACE
+	l->tokens++;
+#endif
+
+	return token;
+}
+
+struct location lexer_location(const struct lexer *l, size_t pos)
+{
+	struct location loc = { .line = 1, .column = 1 };
+	const char *nl = NULL;
+	size_t i = 0;
+
+	if (pos > l->input_len) {
+		pos = l->input_len;
+	}
+	while ((nl = memchr(l->input + i, '\n', pos - i)) != NULL) {
+		i = (size_t) (nl - l->input) + 1;
+		loc.line++;
 	}
+	loc.column = pos - i + 1;
 
-	return TOKEN_ERROR;
+	return loc;
 }
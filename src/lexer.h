@@ -96,15 +96,25 @@ enum token_type {
 	TOKEN_ERROR
 };
 
+struct location {
+	size_t line;
+	size_t column;
+};
+
 struct lexer {
 	bool error;
 	const char *input;
 	size_t input_pos;
 	size_t input_len;
+	size_t token_pos;
 	size_t lexeme_len;
 	size_t lexeme_max;
 	char *lexeme;
 	int lexeme_pos;
+#ifdef ENABLE_TRACE
+	/* Tokens returned by lex() so far */
+	size_t tokens;
+#endif
 };
 
 void lexer_init(struct lexer *l, struct string input);
@@ -112,4 +122,12 @@ void lexer_free(struct lexer *l);
 
 enum token_type lex(struct lexer *l);
 
+/**
+ * \brief Translate input offset to 1-based line and column
+ *
+ * Locations are computed on demand by rescanning the input, so that
+ * the lexer does not have to track lines on every character.
+ */
+struct location lexer_location(const struct lexer *l, size_t pos);
+
 #endif /* LEXER_H */
@@ -0,0 +1,823 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "lsp.h"
+#include "parser.h"
+#include "strbuf.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#define HEADER_MAX 256
+
+#define INVALID_REQUEST  -32600
+#define METHOD_NOT_FOUND -32601
+
+/* Text sync kind of the initialize response */
+#define SYNC_INCREMENTAL 2
+
+struct document {
+	struct strbuf uri;
+	/* Always followed by a zero byte, which the lexer relies on */
+	struct strbuf text;
+	/* Parse of text, redone on every change */
+	struct parse_result result;
+};
+
+struct server {
+	FILE *out;
+	struct document *documents;
+	size_t count;
+	size_t capacity;
+	bool shutdown;
+	bool exit;
+};
+
+/*
+ * JSON values are handled as views into the message: lookup() finds the
+ * text of a member and only strings and integers are ever decoded.
+ */
+
+struct reader {
+	const char *p;
+	const char *end;
+	bool error;
+};
+
+static void reader_init(struct reader *r, struct string s)
+{
+	r->p = string_text(s);
+	r->end = r->p + string_length(s);
+	r->error = false;
+}
+
+static void skip_space(struct reader *r)
+{
+	while (r->p < r->end && isspace((unsigned char) *r->p)) {
+		r->p++;
+	}
+}
+
+static bool accept(struct reader *r, char c)
+{
+	skip_space(r);
+	if (r->p < r->end && *r->p == c) {
+		r->p++;
+		return true;
+	}
+	return false;
+}
+
+static void expect(struct reader *r, char c)
+{
+	if (!accept(r, c)) {
+		r->error = true;
+	}
+}
+
+static void skip_string(struct reader *r)
+{
+	expect(r, '"');
+	while (!r->error && r->p < r->end && *r->p != '"') {
+		r->p += *r->p == '\\' ? 2 : 1;
+	}
+	if (r->p >= r->end) {
+		r->error = true;
+		return;
+	}
+	r->p++;
+}
+
+static void skip_value(struct reader *r)
+{
+	const char *start = NULL;
+
+	skip_space(r);
+	if (accept(r, '{')) {
+		if (accept(r, '}')) {
+			return;
+		}
+		do {
+			skip_string(r);
+			expect(r, ':');
+			skip_value(r);
+		} while (!r->error && accept(r, ','));
+		expect(r, '}');
+	} else if (accept(r, '[')) {
+		if (accept(r, ']')) {
+			return;
+		}
+		do {
+			skip_value(r);
+		} while (!r->error && accept(r, ','));
+		expect(r, ']');
+	} else if (r->p < r->end && *r->p == '"') {
+		skip_string(r);
+	} else {
+		/* Numbers, true, false and null */
+		start = r->p;
+		while (r->p < r->end && (isalnum((unsigned char) *r->p) ||
+					 strchr("+-.", *r->p) != NULL)) {
+			r->p++;
+		}
+		r->error |= r->p == start;
+	}
+}
+
+/* Reads the next value and returns its text. */
+static struct string read_value(struct reader *r)
+{
+	const char *start = NULL;
+
+	skip_space(r);
+	start = r->p;
+	skip_value(r);
+
+	return r->error ? NULL_STRING :
+		string_from_buf_n(start, (size_t) (r->p - start));
+}
+
+static bool member(struct string object, const char *key, size_t length,
+		   struct string *value)
+{
+	struct reader r;
+	const char *name = NULL;
+	size_t name_length = 0;
+
+	reader_init(&r, object);
+	if (!accept(&r, '{') || accept(&r, '}')) {
+		return false;
+	}
+	do {
+		skip_space(&r);
+		name = r.p + 1;
+		skip_string(&r);
+		name_length = (size_t) (r.p - name) - 1;
+		expect(&r, ':');
+		*value = read_value(&r);
+		if (!r.error && name_length == length &&
+		    !memcmp(name, key, length)) {
+			return true;
+		}
+	} while (!r.error && accept(&r, ','));
+
+	return false;
+}
+
+/* Finds the member at a dotted path such as "params.textDocument.uri". */
+static bool lookup(struct string json, const char *path,
+		   struct string *value)
+{
+	const char *dot = NULL;
+
+	*value = json;
+	for (; path != NULL; path = dot != NULL ? dot + 1 : NULL) {
+		dot = strchr(path, '.');
+		if (!member(*value, path, dot != NULL ?
+			    (size_t) (dot - path) : strlen(path), value)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Iterates over an array: the reader starts at the array and every call
+ * returns the next element.
+ */
+static bool next_element(struct reader *r, struct string *value)
+{
+	skip_space(r);
+	if (r->p >= r->end || (*r->p != '[' && *r->p != ',')) {
+		return false;
+	}
+	r->p++;
+	if (accept(r, ']')) {
+		return false;
+	}
+	*value = read_value(r);
+
+	return !r->error;
+}
+
+static void append_utf8(struct strbuf *b, unsigned long c)
+{
+	if (c < 0x80) {
+		strbuf_putc(b, (char) c);
+	} else if (c < 0x800) {
+		strbuf_putc(b, (char) (0xc0 | c >> 6));
+		strbuf_putc(b, (char) (0x80 | (c & 0x3f)));
+	} else if (c < 0x10000) {
+		strbuf_putc(b, (char) (0xe0 | c >> 12));
+		strbuf_putc(b, (char) (0x80 | (c >> 6 & 0x3f)));
+		strbuf_putc(b, (char) (0x80 | (c & 0x3f)));
+	} else {
+		strbuf_putc(b, (char) (0xf0 | c >> 18));
+		strbuf_putc(b, (char) (0x80 | (c >> 12 & 0x3f)));
+		strbuf_putc(b, (char) (0x80 | (c >> 6 & 0x3f)));
+		strbuf_putc(b, (char) (0x80 | (c & 0x3f)));
+	}
+}
+
+static bool read_hex4(struct reader *r, unsigned long *c)
+{
+	char digits[5] = { 0 };
+	char *end = NULL;
+
+	if (r->end - r->p < 4) {
+		return false;
+	}
+	memcpy(digits, r->p, 4);
+	*c = strtoul(digits, &end, 16);
+	r->p += 4;
+
+	return end == digits + 4;
+}
+
+static bool read_escape(struct reader *r, struct strbuf *b)
+{
+	static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+	unsigned long c = 0;
+	unsigned long low = 0;
+
+	if (r->p >= r->end) {
+		return false;
+	}
+	if (*r->p != 'u') {
+		for (size_t i = 0; escapes[i] != '\0'; i += 2) {
+			if (escapes[i] == *r->p) {
+				strbuf_putc(b, escapes[i + 1]);
+				r->p++;
+				return true;
+			}
+		}
+		return false;
+	}
+	r->p++;
+	if (!read_hex4(r, &c)) {
+		return false;
+	}
+	if (c >= 0xd800 && c < 0xdc00 && r->end - r->p >= 6 &&
+	    r->p[0] == '\\' && r->p[1] == 'u') {
+		r->p += 2;
+		if (!read_hex4(r, &low) || low < 0xdc00 || low >= 0xe000) {
+			return false;
+		}
+		c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+	}
+	append_utf8(b, c);
+
+	return true;
+}
+
+/* Appends the decoded JSON string value to b. */
+static bool read_string(struct string value, struct strbuf *b)
+{
+	struct reader r;
+
+	reader_init(&r, value);
+	if (!accept(&r, '"')) {
+		return false;
+	}
+	while (r.p < r.end && *r.p != '"') {
+		const char *start = r.p;
+
+		while (r.p < r.end && *r.p != '"' && *r.p != '\\') {
+			r.p++;
+		}
+		strbuf_append_n(b, start, (size_t) (r.p - start));
+		if (r.p < r.end && *r.p == '\\') {
+			r.p++;
+			if (!read_escape(&r, b)) {
+				return false;
+			}
+		}
+	}
+	return r.p < r.end && !b->failed;
+}
+
+static bool read_size(struct string value, size_t *n)
+{
+	const char *s = string_text(value);
+	size_t length = string_length(value);
+
+	*n = 0;
+	if (length == 0) {
+		return false;
+	}
+	for (size_t i = 0; i < length; i++) {
+		if (!isdigit((unsigned char) s[i])) {
+			return false;
+		}
+		*n = *n * 10 + (size_t) (s[i] - '0');
+	}
+	return true;
+}
+
+static bool lookup_size(struct string json, const char *path, size_t *n)
+{
+	struct string value;
+
+	return lookup(json, path, &value) && read_size(value, n);
+}
+
+static void append_json_string(struct strbuf *b, struct string s)
+{
+	const char *text = string_text(s);
+
+	strbuf_putc(b, '"');
+	for (size_t i = 0; i < string_length(s); i++) {
+		unsigned char c = (unsigned char) text[i];
+
+		if (c == '"' || c == '\\') {
+			strbuf_putc(b, '\\');
+			strbuf_putc(b, (char) c);
+		} else if (c < 0x20) {
+			strbuf_printf(b, "\\u%04x", c);
+		} else {
+			strbuf_putc(b, (char) c);
+		}
+	}
+	strbuf_putc(b, '"');
+}
+
+/*
+ * Positions count UTF-16 code units within a line, offsets count bytes
+ * of UTF-8 text.
+ */
+
+static size_t utf8_length(const char *s, const char *end)
+{
+	unsigned char c = (unsigned char) *s;
+	size_t n = c < 0xc0 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+
+	return n < (size_t) (end - s) ? n : (size_t) (end - s);
+}
+
+static const char *line_start(struct string text, size_t line)
+{
+	const char *s = string_text(text);
+	const char *end = s + string_length(text);
+	const char *nl = NULL;
+
+	for (; line > 0; line--) {
+		if ((nl = memchr(s, '\n', (size_t) (end - s))) == NULL) {
+			return end;
+		}
+		s = nl + 1;
+	}
+	return s;
+}
+
+/* Converts a position to an offset, clamped to its line. */
+static size_t position_offset(struct string text, size_t line,
+			      size_t character)
+{
+	const char *end = string_text(text) + string_length(text);
+	const char *s = line_start(text, line);
+
+	while (s < end && *s != '\n' && character > 0) {
+		size_t n = utf8_length(s, end);
+
+		character -= n == 4 && character > 1 ? 2 : 1;
+		s += n;
+	}
+	return (size_t) (s - string_text(text));
+}
+
+/* Converts a 1-based byte column of a 1-based line to a character. */
+static size_t position_character(struct string text, struct location loc)
+{
+	const char *end = string_text(text) + string_length(text);
+	const char *s = line_start(text, loc.line - 1);
+	const char *stop = s + loc.column - 1;
+	size_t character = 0;
+
+	if (stop > end) {
+		stop = end;
+	}
+	while (s < stop) {
+		size_t n = utf8_length(s, end);
+
+		character += n == 4 ? 2 : 1;
+		s += n;
+	}
+	return character;
+}
+
+static void send(struct server *s, const struct strbuf *message)
+{
+	if (message->failed) {
+		fprintf(stderr, "meson-c: out of memory\n");
+		return;
+	}
+	fprintf(s->out, "Content-Length: %zu\r\n\r\n", message->length);
+	fwrite(message->data, 1, message->length, s->out);
+	fflush(s->out);
+}
+
+static void respond(struct server *s, struct string id, const char *result)
+{
+	struct strbuf b;
+
+	strbuf_init(&b);
+	strbuf_printf(&b, "{\"jsonrpc\":\"2.0\",\"id\":%.*s,\"result\":%s}",
+		      (int) string_length(id), string_text(id), result);
+	send(s, &b);
+	strbuf_free(&b);
+}
+
+static void respond_error(struct server *s, struct string id, int code,
+			  const char *message)
+{
+	struct strbuf b;
+
+	strbuf_init(&b);
+	strbuf_printf(&b, "{\"jsonrpc\":\"2.0\",\"id\":%.*s,"
+		      "\"error\":{\"code\":%d,\"message\":",
+		      (int) string_length(id), string_text(id), code);
+	append_json_string(&b, string_from_buf(message));
+	strbuf_append(&b, CSTRING("}}"));
+	send(s, &b);
+	strbuf_free(&b);
+}
+
+static void publish(struct server *s, const struct document *d)
+{
+	struct string text = strbuf_string(&d->text);
+	struct strbuf b;
+	struct location loc = d->result.location;
+
+	strbuf_init(&b);
+	strbuf_append(&b, CSTRING("{\"jsonrpc\":\"2.0\","
+		"\"method\":\"textDocument/publishDiagnostics\","
+		"\"params\":{\"uri\":"));
+	append_json_string(&b, strbuf_string(&d->uri));
+	strbuf_append(&b, CSTRING(",\"diagnostics\":["));
+	if (!d->result.success) {
+		size_t line = loc.line > 0 ? loc.line - 1 : 0;
+		size_t character = loc.line > 0 ?
+			position_character(text, loc) : 0;
+
+		strbuf_printf(&b, "{\"range\":{"
+			      "\"start\":{\"line\":%zu,\"character\":%zu},"
+			      "\"end\":{\"line\":%zu,\"character\":%zu}},"
+			      "\"severity\":1,\"source\":\"meson-c\","
+			      "\"message\":", line, character, line, character);
+		append_json_string(&b, string_is_null(d->result.error) ?
+				   CSTRING("unknown error") : d->result.error);
+		strbuf_putc(&b, '}');
+	}
+	strbuf_append(&b, CSTRING("]}}"));
+	send(s, &b);
+	strbuf_free(&b);
+}
+
+static void analyze(struct server *s, struct document *d)
+{
+	parse_result_free(&d->result);
+	d->result = parse(strbuf_string(&d->text));
+	publish(s, d);
+}
+
+/* Adds the zero byte after the text. */
+static bool terminate(struct strbuf *b)
+{
+	strbuf_putc(b, '\0');
+	if (b->failed) {
+		return false;
+	}
+	b->length--;
+
+	return true;
+}
+
+static struct document *find(struct server *s, struct string params)
+{
+	struct string value;
+	struct strbuf uri;
+	struct document *d = NULL;
+
+	strbuf_init(&uri);
+	if (lookup(params, "textDocument.uri", &value) &&
+	    read_string(value, &uri)) {
+		for (size_t i = 0; i < s->count && d == NULL; i++) {
+			if (string_equal(strbuf_string(&s->documents[i].uri),
+					 strbuf_string(&uri))) {
+				d = &s->documents[i];
+			}
+		}
+	}
+	strbuf_free(&uri);
+
+	return d;
+}
+
+static void close_document(struct server *s, struct document *d)
+{
+	size_t i = (size_t) (d - s->documents);
+
+	strbuf_free(&d->uri);
+	strbuf_free(&d->text);
+	parse_result_free(&d->result);
+	memmove(d, d + 1, (s->count - i - 1) * sizeof(*d));
+	s->count--;
+}
+
+static void did_open(struct server *s, struct string id, struct string params)
+{
+	struct document *d = NULL;
+	struct document *documents = NULL;
+	struct string uri;
+	struct string text;
+	size_t capacity = s->capacity ? s->capacity * 2 : 8;
+
+	UNUSED(id);
+
+	if (!lookup(params, "textDocument.uri", &uri) ||
+	    !lookup(params, "textDocument.text", &text)) {
+		return;
+	}
+	if ((d = find(s, params)) != NULL) {
+		close_document(s, d);
+	}
+	if (s->count == s->capacity) {
+		documents = mem_realloc_tag(s->documents,
+					    s->capacity * sizeof(*documents),
+					    capacity * sizeof(*documents),
+					    MEM_LSP);
+		if (documents == NULL) {
+			return;
+		}
+		s->documents = documents;
+		s->capacity = capacity;
+	}
+
+	d = &s->documents[s->count];
+	memset(d, 0, sizeof(*d));
+	strbuf_init(&d->uri);
+	strbuf_init(&d->text);
+	if (!read_string(uri, &d->uri) || !read_string(text, &d->text) ||
+	    !terminate(&d->text)) {
+		strbuf_free(&d->uri);
+		strbuf_free(&d->text);
+		return;
+	}
+	s->count++;
+	analyze(s, d);
+}
+
+/*
+ * Applies one content change: text replaces the range if there is one
+ * and the whole document otherwise.
+ */
+static bool apply(struct document *d, struct string change)
+{
+	struct string old = strbuf_string(&d->text);
+	struct string value;
+	struct strbuf text;
+	struct strbuf next;
+	size_t line = 0;
+	size_t character = 0;
+	size_t start = 0;
+	size_t end = 0;
+
+	strbuf_init(&text);
+	if (!lookup(change, "text", &value) || !read_string(value, &text)) {
+		strbuf_free(&text);
+		return false;
+	}
+	if (!lookup(change, "range", &value)) {
+		strbuf_free(&d->text);
+		d->text = text;
+		return terminate(&d->text);
+	}
+	if (!lookup_size(value, "start.line", &line) ||
+	    !lookup_size(value, "start.character", &character)) {
+		strbuf_free(&text);
+		return false;
+	}
+	start = position_offset(old, line, character);
+	if (!lookup_size(value, "end.line", &line) ||
+	    !lookup_size(value, "end.character", &character)) {
+		strbuf_free(&text);
+		return false;
+	}
+	end = position_offset(old, line, character);
+	if (end < start) {
+		end = start;
+	}
+
+	strbuf_init(&next);
+	strbuf_append_n(&next, d->text.data, start);
+	strbuf_append(&next, strbuf_string(&text));
+	strbuf_append_n(&next, d->text.data + end, d->text.length - end);
+	strbuf_free(&text);
+	if (!terminate(&next)) {
+		strbuf_free(&next);
+		return false;
+	}
+	strbuf_free(&d->text);
+	d->text = next;
+
+	return true;
+}
+
+static void did_change(struct server *s, struct string id,
+		       struct string params)
+{
+	struct document *d = find(s, params);
+	struct string changes;
+	struct string change;
+	struct reader r;
+
+	UNUSED(id);
+
+	if (d == NULL || !lookup(params, "contentChanges", &changes)) {
+		return;
+	}
+	reader_init(&r, changes);
+	while (next_element(&r, &change)) {
+		if (!apply(d, change)) {
+			fprintf(stderr, "meson-c: invalid change ignored\n");
+		}
+	}
+	analyze(s, d);
+}
+
+static void did_close(struct server *s, struct string id,
+		      struct string params)
+{
+	struct document *d = find(s, params);
+
+	UNUSED(id);
+
+	if (d != NULL) {
+		close_document(s, d);
+	}
+}
+
+static void initialize(struct server *s, struct string id,
+		       struct string params)
+{
+	char result[256];
+
+	UNUSED(params);
+
+	snprintf(result, sizeof(result), "{\"capabilities\":{"
+		 "\"textDocumentSync\":{\"openClose\":true,\"change\":%d}},"
+		 "\"serverInfo\":{\"name\":\"meson-c\"}}", SYNC_INCREMENTAL);
+	respond(s, id, result);
+}
+
+static void shut_down(struct server *s, struct string id,
+		      struct string params)
+{
+	UNUSED(params);
+
+	s->shutdown = true;
+	respond(s, id, "null");
+}
+
+static void exit_server(struct server *s, struct string id,
+			struct string params)
+{
+	UNUSED(id);
+	UNUSED(params);
+
+	s->exit = true;
+}
+
+static const struct handler {
+	const char *method;
+	void (* handle)(struct server *s, struct string id,
+			struct string params);
+} handlers[] = {
+	{ "initialize", initialize },
+	{ "shutdown", shut_down },
+	{ "exit", exit_server },
+	{ "textDocument/didOpen", did_open },
+	{ "textDocument/didChange", did_change },
+	{ "textDocument/didClose", did_close },
+};
+
+static void dispatch(struct server *s, struct string message)
+{
+	struct reader r;
+	struct string id;
+	struct string value;
+	struct string params;
+	struct strbuf method;
+	const struct handler *h = NULL;
+
+	reader_init(&r, message);
+	skip_value(&r);
+	if (r.error) {
+		fprintf(stderr, "meson-c: invalid message ignored\n");
+		return;
+	}
+	if (!lookup(message, "id", &id)) {
+		id = NULL_STRING;
+	}
+	if (!lookup(message, "params", &params)) {
+		params = CSTRING("{}");
+	}
+
+	strbuf_init(&method);
+	if (lookup(message, "method", &value) &&
+	    read_string(value, &method)) {
+		for (size_t i = 0; i < ARRAY_SIZE(handlers) && h == NULL; i++) {
+			if (string_equal(strbuf_string(&method),
+					 string_from_buf(handlers[i].method))) {
+				h = &handlers[i];
+			}
+		}
+	}
+	strbuf_free(&method);
+
+	if (h != NULL && (!s->shutdown || h->handle == exit_server)) {
+		h->handle(s, id, params);
+	} else if (string_is_null(id)) {
+		/* Unknown notifications are ignored */
+	} else if (s->shutdown) {
+		respond_error(s, id, INVALID_REQUEST, "server is shut down");
+	} else {
+		respond_error(s, id, METHOD_NOT_FOUND, "method not found");
+	}
+}
+
+/* Reads the next message into a zero-terminated buffer. */
+static bool read_message(FILE *in, char **body, size_t *length)
+{
+	char header[HEADER_MAX];
+	bool found = false;
+
+	while (fgets(header, sizeof(header), in) != NULL) {
+		if (!strcmp(header, "\r\n") || !strcmp(header, "\n")) {
+			break;
+		}
+		if (!strncasecmp(header, "Content-Length:", 15)) {
+			*length = strtoul(header + 15, NULL, 10);
+			found = true;
+		}
+	}
+	if (!found) {
+		if (!feof(in)) {
+			fprintf(stderr, "meson-c: message without length\n");
+		}
+		return false;
+	}
+	if ((*body = mem_alloc_tag(*length + 1, MEM_LSP)) == NULL) {
+		fprintf(stderr, "meson-c: out of memory\n");
+		return false;
+	}
+	if (fread(*body, 1, *length, in) != *length) {
+		fprintf(stderr, "meson-c: truncated message\n");
+		mem_free_tag(*body, *length + 1, MEM_LSP);
+		return false;
+	}
+	return true;
+}
+
+int lsp_serve(FILE *in, FILE *out)
+{
+	struct server s = { .out = out };
+	char *body = NULL;
+	size_t length = 0;
+
+	while (!s.exit && read_message(in, &body, &length)) {
+		dispatch(&s, string_from_buf_n(body, length));
+		mem_free_tag(body, length + 1, MEM_LSP);
+	}
+
+	while (s.count > 0) {
+		close_document(&s, &s.documents[s.count - 1]);
+	}
+	if (s.documents != NULL) {
+		mem_free_tag(s.documents, s.capacity * sizeof(*s.documents),
+			     MEM_LSP);
+	}
+
+	return s.exit && s.shutdown ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,53 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef LSP_H
+#define LSP_H
+
+#include "defs.h"
+#include <stdio.h>
+
+/*
+ * Language server for meson.build files.
+ *
+ * Messages are read from in and written to out on the calling thread,
+ * one at a time, with the Content-Length framing of the language server
+ * protocol.  Documents are synchronized incrementally; the server keeps
+ * the text and the parse result of every open document, reparses it on
+ * each change and publishes the parse error, if any, as a diagnostic.
+ *
+ * Supported messages are initialize, initialized, shutdown, exit and
+ * textDocument/didOpen, didChange and didClose; other requests get a
+ * "method not found" error and other notifications are ignored.
+ */
+
+/**
+ * \brief Serve until exit or end of input
+ *
+ * Returns EXIT_SUCCESS if the client sent exit after shutdown and
+ * EXIT_FAILURE otherwise, as the protocol requires.
+ */
+int lsp_serve(FILE *in, FILE *out);
+
+#endif /* LSP_H */
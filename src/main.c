@@ -0,0 +1,420 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "parser.h"
+#include "ast.h"
+#include "common.h"
+#include "lsp.h"
+#include "trace.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Command line driver.
+ *
+ * The driver is invoked many times per build, so it does no work
+ * before a command is selected: there are no global constructors and
+ * every subsystem is set up by the command that needs it.
+ */
+
+struct source {
+	const char *path;
+	struct string text;
+};
+
+static bool read_source(struct source *src, const char *path)
+{
+	FILE *f = NULL;
+	long size = 0;
+	bool ok = false;
+
+	src->path = path;
+	src->text = NULL_STRING;
+
+	if ((f = fopen(path, "rb")) == NULL) {
+		perror(path);
+		return false;
+	}
+	if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET) != 0) {
+		perror(path);
+		goto out;
+	}
+	if ((unsigned long) size >= (1ul << 30)) {
+		fprintf(stderr, "%s: file is too large\n", path);
+		goto out;
+	}
+	if (!(src->text = string_alloc(size)).valid) {
+		fprintf(stderr, "%s: not enough memory\n", path);
+		goto out;
+	}
+	if (fread(string_buffer(src->text), 1, size, f) != (size_t) size) {
+		fprintf(stderr, "%s: read error\n", path);
+		string_free(&src->text);
+		goto out;
+	}
+	ok = true;
+out:
+	fclose(f);
+	return ok;
+}
+
+static bool parse_source(const char *path, struct parse_result *res)
+{
+	struct source src;
+	bool ok = false;
+
+	TRACE_BEGIN_DETAIL("file", path);
+	if ((ok = read_source(&src, path))) {
+		*res = parse(src.text);
+		string_free(&src.text);
+	}
+	TRACE_END();
+
+	if (!ok) {
+		return false;
+	}
+
+	if (!res->success) {
+		fprintf(stderr, "%s:%zu:%zu: error: %s\n", path,
+			res->location.line, res->location.column,
+			string_is_null(res->error) ?
+			"unknown error" : string_text(res->error));
+		parse_result_free(res);
+		return false;
+	}
+	return true;
+}
+
+static const char *subtype_name(enum ast_subtype subtype)
+{
+	static const char *const names[] = {
+		[AST_NONE] = NULL,
+		[AST_ASSIGN] = "=",
+		[AST_ADD_ASSIGN] = "+=", [AST_SUB_ASSIGN] = "-=",
+		[AST_MUL_ASSIGN] = "*=", [AST_DIV_ASSIGN] = "/=",
+		[AST_MOD_ASSIGN] = "%=",
+		[AST_BREAK] = "break", [AST_CONTINUE] = "continue",
+		[AST_NOT] = "not", [AST_PLUS] = "+", [AST_MINUS] = "-",
+		[AST_OR] = "or", [AST_AND] = "and", [AST_TERNARY] = "?:",
+		[AST_ADD] = "+", [AST_SUB] = "-", [AST_MUL] = "*",
+		[AST_DIV] = "/", [AST_MOD] = "%",
+		[AST_EQ] = "==", [AST_NE] = "!=", [AST_LT] = "<",
+		[AST_LE] = "<=", [AST_GT] = ">", [AST_GE] = ">=",
+		[AST_IN] = "in", [AST_NOT_IN] = "not in",
+		[AST_TRUE] = "true", [AST_FALSE] = "false"
+	};
+
+	if ((size_t) subtype >= ARRAY_SIZE(names)) {
+		return NULL;
+	}
+	return names[subtype];
+}
+
+static void dump(FILE *out, void *ptr, int depth);
+
+static void dump_list(FILE *out, struct list *list, int depth)
+{
+	struct list_node *it = NULL;
+	struct ast *ast = NULL;
+
+	while ((ast = list_enum(list, &it)) != NULL) {
+		dump(out, ast, depth);
+	}
+}
+
+static void dump(FILE *out, void *ptr, int depth)
+{
+	struct ast *ast = ptr;
+	const char *subtype = NULL;
+
+	if (ast == NULL) {
+		return;
+	}
+
+	fprintf(out, "%*s%s", depth * 2, "", ast_type_name(ast_type(ast)));
+	if ((subtype = subtype_name(ast_subtype(ast))) != NULL) {
+		fprintf(out, " %s", subtype);
+	}
+
+	switch (ast_type(ast)) {
+	case AST_ID:
+		fprintf(out, " %s\n", string_text(((struct ast_id *) ptr)->name));
+		return;
+	case AST_STRING:
+		fprintf(out, " '%s'\n",
+			string_text(((struct ast_string *) ptr)->value));
+		return;
+	case AST_NUMBER:
+		fprintf(out, " %" PRIi64 "\n", ((struct ast_number *) ptr)->value);
+		return;
+	default:
+		fputc('\n', out);
+		break;
+	}
+
+	depth++;
+
+	switch (ast_type(ast)) {
+	case AST_SEQUENCE:
+		dump_list(out, &((struct ast_seq *) ptr)->exps, depth);
+		break;
+	case AST_ASSIGNMENT:
+	case AST_ARITHMETIC:
+	case AST_RELATIONAL:
+	case AST_LOGICAL:
+		if (ast_subtype(ast) == AST_TERNARY) {
+			struct ast_ternary *t = ptr;
+			dump(out, t->pred, depth);
+			dump(out, t->conseq, depth);
+			dump(out, t->alt, depth);
+		} else {
+			struct ast_binary *b = ptr;
+			dump(out, b->lhs, depth);
+			dump(out, b->rhs, depth);
+		}
+		break;
+	case AST_IF: {
+		struct ast_if *if_ = ptr;
+		dump_list(out, &if_->clauses, depth);
+		dump(out, if_->alt, depth);
+		break;
+	}
+	case AST_IF_CLAUSE: {
+		struct ast_if_clause *c = ptr;
+		dump(out, c->pred, depth);
+		dump(out, c->conseq, depth);
+		break;
+	}
+	case AST_FOREACH: {
+		struct ast_foreach *foreach = ptr;
+		dump_list(out, &foreach->ids, depth);
+		dump(out, foreach->exp, depth);
+		dump(out, foreach->body, depth);
+		break;
+	}
+	case AST_UNARY:
+		dump(out, ((struct ast_unary *) ptr)->exp, depth);
+		break;
+	case AST_MEMBER: {
+		struct ast_member *m = ptr;
+		dump(out, m->obj, depth);
+		dump(out, m->field, depth);
+		break;
+	}
+	case AST_INDEX: {
+		struct ast_index *s = ptr;
+		dump(out, s->ref, depth);
+		dump(out, s->index, depth);
+		break;
+	}
+	case AST_APPLICATION: {
+		struct ast_app *app = ptr;
+		dump(out, app->ref, depth);
+		dump_list(out, &app->args, depth);
+		dump_list(out, &app->kw_args, depth);
+		break;
+	}
+	case AST_KEYWORD_ARG: {
+		struct ast_kw_arg *kw = ptr;
+		dump(out, kw->id, depth);
+		dump(out, kw->exp, depth);
+		break;
+	}
+	case AST_ARRAY:
+		dump_list(out, &((struct ast_array *) ptr)->elts, depth);
+		break;
+	case AST_DICTIONARY:
+		dump_list(out, &((struct ast_dict *) ptr)->map, depth);
+		break;
+	case AST_KV: {
+		struct ast_kv *kv = ptr;
+		dump(out, kv->key, depth);
+		dump(out, kv->value, depth);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/*
+ * Parses every file, reporting errors, and hands each syntax tree to
+ * action if there is one.
+ */
+static int parse_files(int argc, char **argv,
+		       void (* action)(const char *path, struct ast *ast,
+				       int count))
+{
+	struct parse_result res;
+	int status = EXIT_SUCCESS;
+
+	for (int i = 0; i < argc; i++) {
+		if (!parse_source(argv[i], &res)) {
+			status = EXIT_FAILURE;
+			continue;
+		}
+		if (action != NULL) {
+			action(argv[i], res.ast, argc);
+		}
+		parse_result_free(&res);
+	}
+	return status;
+}
+
+static void print_ok(const char *path, struct ast *ast, int count)
+{
+	UNUSED(ast);
+	UNUSED(count);
+
+	printf("%s: ok\n", path);
+}
+
+static void print_ast(const char *path, struct ast *ast, int count)
+{
+	if (count > 1) {
+		printf("%s:\n", path);
+	}
+	dump(stdout, ast, 0);
+}
+
+static int cmd_parse(int argc, char **argv)
+{
+	return parse_files(argc, argv, print_ok);
+}
+
+static int cmd_check(int argc, char **argv)
+{
+	return parse_files(argc, argv, NULL);
+}
+
+static int cmd_dump_ast(int argc, char **argv)
+{
+	return parse_files(argc, argv, print_ast);
+}
+
+static int cmd_lsp(int argc, char **argv)
+{
+	UNUSED(argc);
+	UNUSED(argv);
+
+	return lsp_serve(stdin, stdout);
+}
+
+static const struct command {
+	const char *name;
+	const char *args;
+	const char *help;
+	int (* run)(int argc, char **argv);
+	int min_args;
+} commands[] = {
+	{ "parse", "FILE...", "parse files and report errors", cmd_parse, 1 },
+	{ "check", "FILE...", "same as parse, but only set exit status", cmd_check, 1 },
+	{ "dump-ast", "FILE...", "print syntax trees", cmd_dump_ast, 1 },
+	{ "lsp", "", "run a language server on stdin and stdout", cmd_lsp, 0 },
+};
+
+static int usage(FILE *out, int status)
+{
+	fprintf(out, "usage: meson-c [--trace FILE] COMMAND [ARGS...]\n\n"
+		"commands:\n");
+	for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+		fprintf(out, "  %-10s %-11s %s\n", commands[i].name,
+			commands[i].args, commands[i].help);
+	}
+	return status;
+}
+
+static bool write_trace(const char *path)
+{
+#ifdef ENABLE_TRACE
+	FILE *f = NULL;
+	bool ok = false;
+
+	if ((f = fopen(path, "w")) == NULL) {
+		perror(path);
+		return false;
+	}
+	ok = trace_write(f);
+	ok &= fclose(f) == 0;
+	if (!ok) {
+		fprintf(stderr, "%s: write error\n", path);
+	}
+	return ok;
+#else
+	UNUSED(path);
+	fprintf(stderr, "meson-c: built without tracing, rebuild with TRACE=1\n");
+	return false;
+#endif
+}
+
+static int run(int argc, char **argv)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(commands); i++) {
+		if (strcmp(argv[0], commands[i].name) != 0) {
+			continue;
+		}
+		if (argc - 1 < commands[i].min_args) {
+			fprintf(stderr, "usage: meson-c %s %s\n",
+				commands[i].name, commands[i].args);
+			return EXIT_FAILURE;
+		}
+		return commands[i].run(argc - 1, argv + 1);
+	}
+
+	fprintf(stderr, "meson-c: unknown command `%s'\n", argv[0]);
+	return usage(stderr, EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+	const char *trace = NULL;
+	int status = EXIT_SUCCESS;
+
+	argc--;
+	argv++;
+
+	if (argc > 0 && !strcmp(argv[0], "--trace")) {
+		if (argc < 2) {
+			return usage(stderr, EXIT_FAILURE);
+		}
+		trace = argv[1];
+		argc -= 2;
+		argv += 2;
+	}
+	if (argc < 1) {
+		return usage(stderr, EXIT_FAILURE);
+	}
+	if (!strcmp(argv[0], "-h") || !strcmp(argv[0], "--help")) {
+		return usage(stdout, EXIT_SUCCESS);
+	}
+
+	status = run(argc, argv);
+	if (trace != NULL && !write_trace(trace)) {
+		status = EXIT_FAILURE;
+	}
+
+	return status;
+}
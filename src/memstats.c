@@ -0,0 +1,172 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "memstats.h"
+
+#ifdef ENABLE_MEM_STATS
+#include <stdatomic.h>
+
+struct counters {
+	atomic_size_t allocs;
+	atomic_size_t frees;
+	atomic_size_t bytes;
+	atomic_size_t live;
+};
+
+static struct counters tags[MEM_TAG_COUNT];
+static atomic_size_t live;
+static atomic_size_t peak;
+static atomic_size_t histogram[MEM_HISTOGRAM_SIZE];
+
+static size_t size_class(size_t size)
+{
+	size_t n = 0;
+
+	while (size != 0 && n < MEM_HISTOGRAM_SIZE - 1) {
+		size >>= 1;
+		n++;
+	}
+	return n;
+}
+
+void mem_stats_alloc(enum mem_tag tag, size_t size)
+{
+	size_t now = 0;
+	size_t max = 0;
+
+	assert(tag < MEM_TAG_COUNT);
+
+	atomic_fetch_add_explicit(&tags[tag].allocs, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&tags[tag].bytes, size, memory_order_relaxed);
+	atomic_fetch_add_explicit(&tags[tag].live, size, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram[size_class(size)], 1,
+				  memory_order_relaxed);
+
+	now = atomic_fetch_add_explicit(&live, size, memory_order_relaxed) + size;
+	max = atomic_load_explicit(&peak, memory_order_relaxed);
+	while (now > max &&
+	       !atomic_compare_exchange_weak_explicit(&peak, &max, now,
+			memory_order_relaxed, memory_order_relaxed)) {
+		continue;
+	}
+}
+
+void mem_stats_free(enum mem_tag tag, size_t size)
+{
+	assert(tag < MEM_TAG_COUNT);
+
+	atomic_fetch_add_explicit(&tags[tag].frees, 1, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&tags[tag].live, size, memory_order_relaxed);
+	atomic_fetch_sub_explicit(&live, size, memory_order_relaxed);
+}
+
+bool mem_stats_get(struct mem_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+		stats->tags[i].allocs = atomic_load(&tags[i].allocs);
+		stats->tags[i].frees = atomic_load(&tags[i].frees);
+		stats->tags[i].bytes = atomic_load(&tags[i].bytes);
+		stats->tags[i].live = atomic_load(&tags[i].live);
+	}
+	for (size_t i = 0; i < MEM_HISTOGRAM_SIZE; i++) {
+		stats->histogram[i] = atomic_load(&histogram[i]);
+	}
+	stats->live = atomic_load(&live);
+	stats->peak = atomic_load(&peak);
+
+	return true;
+}
+
+void mem_stats_reset(void)
+{
+	for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+		atomic_store(&tags[i].allocs, 0);
+		atomic_store(&tags[i].frees, 0);
+		atomic_store(&tags[i].bytes, 0);
+	}
+	for (size_t i = 0; i < MEM_HISTOGRAM_SIZE; i++) {
+		atomic_store(&histogram[i], 0);
+	}
+	atomic_store(&peak, atomic_load(&live));
+}
+
+#else
+
+bool mem_stats_get(struct mem_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	return false;
+}
+
+void mem_stats_reset(void)
+{
+}
+
+#endif /* ENABLE_MEM_STATS */
+
+const char *mem_tag_name(enum mem_tag tag)
+{
+	switch (tag) {
+#define GEN(N) \
+	case MEM_##N: return #N;
+		MEM_TAG_MAP(GEN)
+#undef GEN
+#define GEN(N) \
+	case MEM_AST_##N: return "AST_" #N;
+		AST_TYPE_MAP(GEN)
+#undef GEN
+	default: return "unknown";
+	}
+}
+
+bool mem_stats_write(FILE *out, const struct mem_stats *stats)
+{
+	size_t last = 0;
+
+	fprintf(out, "{\"live\":%zu,\"peak\":%zu,\"tags\":{",
+		stats->live, stats->peak);
+	for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+		const struct mem_tag_stats *t = &stats->tags[i];
+
+		fprintf(out, "%s\"%s\":{\"allocs\":%zu,\"frees\":%zu,"
+			"\"bytes\":%zu,\"live\":%zu}", i ? "," : "",
+			mem_tag_name(i), t->allocs, t->frees, t->bytes, t->live);
+	}
+
+	/* Histogram is trimmed after the last non-empty size class. */
+	for (size_t i = 0; i < MEM_HISTOGRAM_SIZE; i++) {
+		if (stats->histogram[i] != 0) {
+			last = i + 1;
+		}
+	}
+	fputs("},\"histogram\":[", out);
+	for (size_t i = 0; i < last; i++) {
+		fprintf(out, "%s%zu", i ? "," : "", stats->histogram[i]);
+	}
+	fputs("]}", out);
+
+	return !ferror(out);
+}
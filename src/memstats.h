@@ -0,0 +1,87 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include "common.h"
+#include <stdio.h>
+
+/*
+ * Allocation statistics.
+ *
+ * Counters are maintained only when the library is built with
+ * MEM_STATS=1 (which defines ENABLE_MEM_STATS); otherwise the hooks
+ * below expand to nothing and mem_stats_get() reports failure.
+ */
+
+/* Size classes: bucket N counts allocations of less than 2^N bytes. */
+#define MEM_HISTOGRAM_SIZE 32
+
+struct mem_tag_stats {
+	size_t allocs;
+	size_t frees;
+	/* Total bytes ever allocated */
+	size_t bytes;
+	/* Bytes currently allocated */
+	size_t live;
+};
+
+struct mem_stats {
+	struct mem_tag_stats tags[MEM_TAG_COUNT];
+	size_t live;
+	size_t peak;
+	size_t histogram[MEM_HISTOGRAM_SIZE];
+};
+
+const char *mem_tag_name(enum mem_tag tag);
+
+bool mem_stats_get(struct mem_stats *stats);
+
+/**
+ * \brief Reset counters
+ *
+ * Clears allocation counts, totals and the histogram; live bytes are
+ * kept and the peak restarts from the current live size.
+ */
+void mem_stats_reset(void);
+
+bool mem_stats_write(FILE *out, const struct mem_stats *stats);
+
+#ifdef ENABLE_MEM_STATS
+
+void mem_stats_alloc(enum mem_tag tag, size_t size);
+void mem_stats_free(enum mem_tag tag, size_t size);
+
+#define MEM_STATS_ALLOC(tag, size)	mem_stats_alloc(tag, size)
+#define MEM_STATS_FREE(tag, size)	mem_stats_free(tag, size)
+
+#else
+
+#define MEM_STATS_ALLOC(tag, size)	((void) (tag), (void) (size))
+#define MEM_STATS_FREE(tag, size)	((void) (tag), (void) (size))
+
+#endif /* ENABLE_MEM_STATS */
+
+#endif /* MEMSTATS_H */
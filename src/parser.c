@@ -25,6 +25,7 @@
 #include "parser.h"
 #include "ast.h"
 #include "common.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -36,6 +37,8 @@ struct result {
 		struct ast *ast;
 		struct string error;
 	};
+	/* Input offset of the offending token on failure */
+	size_t offset;
 };
 
 static enum token_type peek(struct parser *p)
@@ -86,8 +89,6 @@ static struct result with_error(struct parser *p, const char *format, ...)
 	va_list args;
 	char buffer[1024];
 
-	UNUSED(p);
-
 	va_start(args, format);
 	buffer[0] = '\0';
 	vsnprintf(buffer, sizeof(buffer), format, args);
@@ -95,7 +96,8 @@ static struct result with_error(struct parser *p, const char *format, ...)
 
 	return (struct result) {
 		.status = FAILURE,
-		.error = string_dup(buffer)
+		.error = string_dup(buffer),
+		.offset = p->lexer.token_pos
 	};
 }
 
@@ -479,15 +481,27 @@ static struct result postfix(struct parser *p)
 {
 	struct ast *ast = NULL;
 	struct result res = { .status = FAILURE };
+	bool string = false;
 
 	if ((res = primary(p)).status) {
 		return res;
 	}
-	if (ast_type(ast = res.ast) != AST_ID) {
+	/*
+	 * String literals take methods and subscripts, '@0@'.format(x)
+	 * and 'abc'[0], but only their methods can be called.
+	 */
+	ast = res.ast;
+	string = ast_type(ast) == AST_STRING;
+	if (!string && ast_type(ast) != AST_ID) {
 		return res;
 	}
 
 	while (res.status == 0) {
+		if (string && peek(p) == TOKEN_L_PAREN &&
+		    ast_type(ast) != AST_MEMBER) {
+			res = with_error(p, "string is not callable");
+			break;
+		}
 		switch (peek(p)) {
 		case TOKEN_DOT: {
 			struct ast *right = NULL;
@@ -1083,12 +1097,22 @@ struct parse_result parse(struct string source)
 {
 	struct parser p;
 	struct result res = { .status = FAILURE };
+	struct location location = { 0 };
+
+	TRACE_BEGIN("parse");
+	TRACE_COUNTER("parse.bytes", string_length(source));
 
 	memset(&p, 0, sizeof(p));
 	lexer_init(&p.lexer, source);
 	res = sequence(&p);
+	if (res.status == FAILURE) {
+		location = lexer_location(&p.lexer, res.offset);
+	}
+	TRACE_COUNTER("parse.tokens", p.lexer.tokens);
 	lexer_free(&p.lexer);
 
+	TRACE_END();
+
 	switch (res.status) {
 	case SUCCESS:
 		assert(res.ast != NULL);
@@ -1097,7 +1121,7 @@ struct parse_result parse(struct string source)
 		};
 	case FAILURE:
 		return (struct parse_result) {
-			.error = res.error
+			.error = res.error, .location = location
 		};
 	case NO_MEMORY:
 		return (struct parse_result) {
@@ -1113,7 +1137,9 @@ struct parse_result parse(struct string source)
 void parse_result_free(struct parse_result *result)
 {
 	if (result->success) {
+		TRACE_BEGIN("ast_free");
 		ast_free(result->ast);
+		TRACE_END();
 	} else {
 		string_free(&result->error);
 	}
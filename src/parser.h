@@ -40,6 +40,8 @@ struct parse_result {
 		struct ast *ast;
 		struct string error;
 	};
+	/* Where the error was detected, zeroed on success */
+	struct location location;
 };
 
 struct parse_result parse(struct string source);
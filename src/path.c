@@ -0,0 +1,274 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "path.h"
+
+#define INITIAL_CAPACITY 64
+
+static uint32_t mix(uint32_t parent, uint32_t name)
+{
+	return parent ^ (name + 0x9e3779b9u + (parent << 6) + (parent >> 2));
+}
+
+bool path_table_init(struct path_table *t)
+{
+	memset(t, 0, sizeof(*t));
+	atom_table_init(&t->atoms);
+
+	t->root = (struct path) { .hash = 1, .length = 1, .absolute = true };
+	t->cwd = (struct path) { .hash = 2, .length = 1, .absolute = false };
+
+	return (t->up = atom_intern(&t->atoms, CSTRING(".."))) != NULL;
+}
+
+void path_table_free(struct path_table *t)
+{
+	for (size_t i = 0; i < t->capacity; i++) {
+		if (t->slots[i] != NULL) {
+			mem_free_tag((void *) t->slots[i], sizeof(struct path),
+				     MEM_PATH);
+		}
+	}
+	if (t->slots != NULL) {
+		mem_free_tag(t->slots, t->capacity * sizeof(*t->slots),
+			     MEM_PATH);
+	}
+	atom_table_free(&t->atoms);
+	memset(t, 0, sizeof(*t));
+}
+
+static const struct path **probe(const struct path **slots, size_t capacity,
+				 uint32_t hash, const struct path *parent,
+				 const struct atom *name)
+{
+	size_t mask = capacity - 1;
+	size_t i = hash & mask;
+
+	while (slots[i] != NULL &&
+	       (slots[i]->parent != parent || slots[i]->name != name)) {
+		i = (i + 1) & mask;
+	}
+	return &slots[i];
+}
+
+static bool grow(struct path_table *t)
+{
+	size_t capacity = t->capacity ? t->capacity * 2 : INITIAL_CAPACITY;
+	const struct path **slots = NULL;
+
+	if ((slots = mem_alloc_tag(capacity * sizeof(*slots),
+				   MEM_PATH)) == NULL) {
+		return false;
+	}
+	for (size_t i = 0; i < t->capacity; i++) {
+		const struct path *p = t->slots[i];
+
+		if (p != NULL) {
+			*probe(slots, capacity, p->hash, p->parent, p->name) = p;
+		}
+	}
+	if (t->slots != NULL) {
+		mem_free_tag(t->slots, t->capacity * sizeof(*t->slots),
+			     MEM_PATH);
+	}
+	t->slots = slots;
+	t->capacity = capacity;
+
+	return true;
+}
+
+static const struct path *child(struct path_table *t,
+				const struct path *parent,
+				const struct atom *name)
+{
+	uint32_t hash = mix(parent->hash, name->hash);
+	const struct path **slot = NULL;
+	struct path *p = NULL;
+
+	if (t->capacity > 0) {
+		slot = probe(t->slots, t->capacity, hash, parent, name);
+		if (*slot != NULL) {
+			return *slot;
+		}
+	}
+	if ((t->count + 1) * 4 > t->capacity * 3) {
+		if (!grow(t)) {
+			return NULL;
+		}
+		slot = probe(t->slots, t->capacity, hash, parent, name);
+	}
+
+	if ((p = mem_alloc_tag(sizeof(*p), MEM_PATH)) == NULL) {
+		return NULL;
+	}
+	p->parent = parent;
+	p->name = name;
+	p->hash = hash;
+	p->depth = parent->depth + 1;
+	p->absolute = parent->absolute;
+	if (parent->depth == 0) {
+		p->length = name->length + (p->absolute ? 1 : 0);
+	} else {
+		p->length = parent->length + 1 + name->length;
+	}
+
+	t->count++;
+	return *slot = p;
+}
+
+const struct path *path_intern(struct path_table *t, const struct path *base,
+			       struct string s)
+{
+	const struct path *p = base != NULL ? base : &t->cwd;
+	struct string_split it;
+	struct string part;
+
+	if (string_startswith(s, CSTRING("/"))) {
+		p = &t->root;
+	}
+
+	string_split_init(&it, s, CSTRING("/"));
+	while (p != NULL && string_split_next(&it, &part)) {
+		const struct atom *name = NULL;
+
+		if (string_length(part) == 0 ||
+		    string_equal(part, CSTRING("."))) {
+			continue;
+		}
+		if (string_equal(part, CSTRING(".."))) {
+			if (p->depth > 0 && p->name != t->up) {
+				p = p->parent;
+				continue;
+			}
+			if (p->absolute) {
+				/* `/..' is `/'. */
+				continue;
+			}
+		}
+		if ((name = atom_intern(&t->atoms, part)) == NULL) {
+			return NULL;
+		}
+		p = child(t, p, name);
+	}
+
+	return p;
+}
+
+const struct path *path_common_ancestor(const struct path *a,
+					const struct path *b)
+{
+	if (a->absolute != b->absolute) {
+		return NULL;
+	}
+	while (a->depth > b->depth) {
+		a = a->parent;
+	}
+	while (b->depth > a->depth) {
+		b = b->parent;
+	}
+	/* Both roots are reached at the same time. */
+	while (a != b && a->depth > 0) {
+		a = a->parent;
+		b = b->parent;
+	}
+	return a == b ? a : NULL;
+}
+
+/*
+ * Writes the components of p below its ancestor at the given depth so
+ * that they end at end.
+ */
+static void fill(char *end, const struct path *p, uint32_t depth)
+{
+	for (; p->depth > depth; p = p->parent) {
+		end -= p->name->length;
+		memcpy(end, p->name->text, p->name->length);
+		if (p->depth > depth + 1) {
+			*--end = '/';
+		}
+	}
+}
+
+struct string path_string(const struct path *p)
+{
+	struct string s;
+	char *buffer = NULL;
+
+	if (p->depth == 0) {
+		return p->absolute ? CSTRING("/") : CSTRING(".");
+	}
+	if (!(s = string_alloc(p->length)).valid) {
+		return NULL_STRING;
+	}
+	buffer = string_buffer(s);
+	fill(buffer + p->length, p, 0);
+	if (p->absolute) {
+		buffer[0] = '/';
+	}
+	return s;
+}
+
+struct string path_relative(const struct path_table *t,
+			    const struct path *p, const struct path *from)
+{
+	const struct path *ancestor = NULL;
+	size_t ups = 0;
+	size_t downs = 0;
+	size_t length = 0;
+	struct string s;
+	char *out = NULL;
+
+	if ((ancestor = path_common_ancestor(p, from)) == NULL) {
+		return NULL_STRING;
+	}
+	for (const struct path *n = from; n != ancestor; n = n->parent) {
+		if (n->name == t->up) {
+			return NULL_STRING;
+		}
+		ups++;
+	}
+	for (const struct path *n = p; n != ancestor; n = n->parent) {
+		length += n->name->length;
+		downs++;
+	}
+	if (ups + downs == 0) {
+		return CSTRING(".");
+	}
+	length += ups * 2 + (ups + downs - 1);
+
+	if (!(s = string_alloc(length)).valid) {
+		return NULL_STRING;
+	}
+	out = string_buffer(s);
+	for (size_t i = 0; i < ups; i++) {
+		*out++ = '.';
+		*out++ = '.';
+		if (i + 1 < ups + downs) {
+			*out++ = '/';
+		}
+	}
+	fill(string_buffer(s) + length, p, ancestor->depth);
+
+	return s;
+}
@@ -0,0 +1,112 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PATH_H
+#define PATH_H
+
+#include "atom.h"
+
+/*
+ * Interned, normalized paths.
+ *
+ * A path is a node holding its last component as an atom and a pointer
+ * to the parent path.  Paths are normalized once, when they are
+ * created: empty and `.' components are dropped and `..' removes the
+ * preceding component where there is one.  Every distinct path exists
+ * once per table, so two paths from the same table are equal exactly
+ * when their pointers are.
+ *
+ * Each table has two roots, `/' for absolute paths and `.' for relative
+ * ones.  A relative path that climbs above its root keeps its leading
+ * `..' components.
+ */
+
+struct path {
+	const struct path *parent;
+	/* Null for the roots */
+	const struct atom *name;
+	uint32_t hash;
+	/* Number of components */
+	uint32_t depth;
+	/* Length of the path as text */
+	uint32_t length;
+	bool absolute;
+};
+
+struct path_table {
+	struct atom_table atoms;
+	const struct path **slots;
+	size_t capacity;
+	size_t count;
+	struct path root;
+	struct path cwd;
+	/* The `..' atom */
+	const struct atom *up;
+};
+
+bool path_table_init(struct path_table *t);
+void path_table_free(struct path_table *t);
+
+/**
+ * \brief Intern a path
+ *
+ * A relative s is taken relative to base, or to the relative root if
+ * base is null; an absolute s ignores base.  This also serves as
+ * join_paths() and the `/' operator.  Returns null on allocation
+ * failure.
+ */
+const struct path *path_intern(struct path_table *t, const struct path *base,
+			       struct string s);
+
+static inline const struct path *path_parent(const struct path *p)
+{
+	return p->parent != NULL ? p->parent : p;
+}
+
+static inline struct string path_name(const struct path *p)
+{
+	return p->name != NULL ? atom_string(p->name) : CSTRING("");
+}
+
+/**
+ * \brief Deepest path both a and b are under
+ *
+ * Returns null if one path is absolute and the other one is not.
+ */
+const struct path *path_common_ancestor(const struct path *a,
+					const struct path *b);
+
+struct string path_string(const struct path *p);
+
+/**
+ * \brief Path of p relative to from, as used in ninja files
+ *
+ * Returns a null string if there is no such path, which is when one is
+ * absolute and the other one is not, or when from climbs above the
+ * common ancestor with `..'.
+ */
+struct string path_relative(const struct path_table *t,
+			    const struct path *p, const struct path *from);
+
+#endif /* PATH_H */
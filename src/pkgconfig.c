@@ -0,0 +1,368 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "pkgconfig.h"
+
+#define INITIAL_CAPACITY 64
+
+bool pkgconfig_init(struct pkgconfig *pc)
+{
+	memset(pc, 0, sizeof(*pc));
+	atom_table_init(&pc->atoms);
+
+	return args_table_init(&pc->args, &pc->atoms);
+}
+
+void pkgconfig_free(struct pkgconfig *pc)
+{
+	for (size_t i = 0; i < pc->capacity; i++) {
+		if (pc->slots[i] != NULL) {
+			mem_free_tag(pc->slots[i], sizeof(*pc->slots[i]),
+				     MEM_PKGCONFIG);
+		}
+	}
+	if (pc->slots != NULL) {
+		mem_free_tag(pc->slots, pc->capacity * sizeof(*pc->slots),
+			     MEM_PKGCONFIG);
+	}
+	args_table_free(&pc->args);
+	atom_table_free(&pc->atoms);
+	memset(pc, 0, sizeof(*pc));
+}
+
+static struct pkgconfig_closure **probe(struct pkgconfig_closure **slots,
+					size_t capacity,
+					const struct pkgconfig_lib *lib)
+{
+	size_t mask = capacity - 1;
+	size_t i = atom_hash(&lib, sizeof(lib)) & mask;
+
+	while (slots[i] != NULL && slots[i]->lib != lib) {
+		i = (i + 1) & mask;
+	}
+	return &slots[i];
+}
+
+static bool grow(struct pkgconfig *pc)
+{
+	size_t capacity = pc->capacity ? pc->capacity * 2 : INITIAL_CAPACITY;
+	struct pkgconfig_closure **slots = NULL;
+
+	if ((slots = mem_alloc_tag(capacity * sizeof(*slots),
+				   MEM_PKGCONFIG)) == NULL) {
+		return false;
+	}
+	for (size_t i = 0; i < pc->capacity; i++) {
+		if (pc->slots[i] != NULL) {
+			*probe(slots, capacity, pc->slots[i]->lib) =
+				pc->slots[i];
+		}
+	}
+	if (pc->slots != NULL) {
+		mem_free_tag(pc->slots, pc->capacity * sizeof(*pc->slots),
+			     MEM_PKGCONFIG);
+	}
+	pc->slots = slots;
+	pc->capacity = capacity;
+
+	return true;
+}
+
+/* Closures live in their own allocations, so the pointers are stable. */
+static struct pkgconfig_closure *entry(struct pkgconfig *pc,
+				       const struct pkgconfig_lib *lib)
+{
+	struct pkgconfig_closure **slot = NULL;
+
+	if (pc->capacity > 0 && *(slot = probe(pc->slots, pc->capacity,
+					       lib)) != NULL) {
+		return *slot;
+	}
+	if ((pc->count + 1) * 4 > pc->capacity * 3) {
+		if (!grow(pc)) {
+			return NULL;
+		}
+		slot = probe(pc->slots, pc->capacity, lib);
+	}
+	if ((*slot = mem_alloc_tag(sizeof(**slot), MEM_PKGCONFIG)) == NULL) {
+		return NULL;
+	}
+	(*slot)->lib = lib;
+	pc->count++;
+
+	return *slot;
+}
+
+/*
+ * Interns items without repeats, keeping the first or the last copy of
+ * each.  Items are atoms, so a pointer set finds the repeats.
+ */
+static uint32_t unique(struct pkgconfig *pc, const struct atom **items,
+		       size_t count, bool last)
+{
+	const struct atom **seen = NULL;
+	size_t capacity = 16;
+	size_t n = 0;
+	uint32_t id = ARGS_INVALID;
+
+	while (capacity < count * 2) {
+		capacity *= 2;
+	}
+	if ((seen = mem_alloc_tag(capacity * sizeof(*seen),
+				  MEM_PKGCONFIG)) == NULL) {
+		return ARGS_INVALID;
+	}
+	for (size_t k = 0; k < count; k++) {
+		const struct atom *a = items[last ? count - 1 - k : k];
+		size_t i = a->hash & (capacity - 1);
+
+		while (seen[i] != NULL && seen[i] != a) {
+			i = (i + 1) & (capacity - 1);
+		}
+		if (seen[i] == NULL) {
+			seen[i] = a;
+			items[last ? count - 1 - n : n] = a;
+			n++;
+		}
+	}
+	id = args_intern(&pc->args, last ? items + count - n : items, n);
+
+	mem_free_tag(seen, capacity * sizeof(*seen), MEM_PKGCONFIG);
+	return id;
+}
+
+static const struct atom *lib_flag(struct pkgconfig *pc,
+				   const struct pkgconfig_lib *lib)
+{
+	const struct string parts[] = { CSTRING("-l"), lib->name };
+	struct string flag = string_join(CSTRING(""), parts, 2);
+	const struct atom *a = NULL;
+
+	if (!flag.valid) {
+		return NULL;
+	}
+	a = atom_intern(&pc->atoms, flag);
+	string_free(&flag);
+
+	return a;
+}
+
+static void append(const struct atom **items, size_t *n,
+		   const struct args *l)
+{
+	memcpy(items + *n, l->items, l->count * sizeof(*items));
+	*n += l->count;
+}
+
+/*
+ * Concatenates, for each dependency in order, its -l flag and its own
+ * closure, then keeps the last copy of every flag.  Each part lists a
+ * library before everything it depends on, and keeping last copies
+ * preserves that, so the result is in reverse topological order as
+ * static linking needs.  Packages keep their first copy.
+ */
+static bool combine(struct pkgconfig *pc, struct pkgconfig_closure *c)
+{
+	const struct pkgconfig_lib *lib = c->lib;
+	const struct atom **libs = NULL;
+	const struct atom **requires = NULL;
+	size_t libs_size = 0, requires_size = 0;
+	size_t libs_count = 0, requires_count = 0;
+	bool ok = false;
+
+	for (size_t i = 0; i < lib->dep_count; i++) {
+		const struct pkgconfig_closure *d = NULL;
+
+		if (!string_is_null(lib->deps[i]->package)) {
+			requires_size++;
+			continue;
+		}
+		d = entry(pc, lib->deps[i]);
+		libs_size += 1 + args_get(&pc->args, d->libs)->count;
+		requires_size += args_get(&pc->args, d->requires)->count;
+	}
+	if ((libs = mem_alloc_tag((libs_size + 1) * sizeof(*libs),
+				  MEM_PKGCONFIG)) == NULL ||
+	    (requires = mem_alloc_tag((requires_size + 1) * sizeof(*requires),
+				      MEM_PKGCONFIG)) == NULL) {
+		goto out;
+	}
+
+	for (size_t i = 0; i < lib->dep_count; i++) {
+		const struct pkgconfig_lib *dep = lib->deps[i];
+		const struct pkgconfig_closure *d = NULL;
+
+		if (!string_is_null(dep->package)) {
+			if ((requires[requires_count++] =
+			     atom_intern(&pc->atoms, dep->package)) == NULL) {
+				goto out;
+			}
+			continue;
+		}
+		d = entry(pc, dep);
+		if ((libs[libs_count++] = lib_flag(pc, dep)) == NULL) {
+			goto out;
+		}
+		append(libs, &libs_count, args_get(&pc->args, d->libs));
+		append(requires, &requires_count,
+		       args_get(&pc->args, d->requires));
+	}
+
+	c->libs = unique(pc, libs, libs_count, true);
+	c->requires = unique(pc, requires, requires_count, false);
+	ok = c->libs != ARGS_INVALID && c->requires != ARGS_INVALID;
+out:
+	if (libs != NULL) {
+		mem_free_tag(libs, (libs_size + 1) * sizeof(*libs),
+			     MEM_PKGCONFIG);
+	}
+	if (requires != NULL) {
+		mem_free_tag(requires, (requires_size + 1) * sizeof(*requires),
+			     MEM_PKGCONFIG);
+	}
+	return ok;
+}
+
+const struct pkgconfig_closure *pkgconfig_closure(struct pkgconfig *pc,
+						  const struct pkgconfig_lib *lib,
+						  const char **error)
+{
+	struct pkgconfig_closure *c = NULL;
+
+	if ((c = entry(pc, lib)) == NULL) {
+		*error = "out of memory";
+		return NULL;
+	}
+	if (c->done) {
+		return c;
+	}
+	/* Entered but not done: the library depends on itself. */
+	if (c->requires == ARGS_INVALID) {
+		*error = "dependency cycle";
+		return NULL;
+	}
+	c->requires = ARGS_INVALID;
+
+	for (size_t i = 0; i < lib->dep_count; i++) {
+		if (string_is_null(lib->deps[i]->package) &&
+		    pkgconfig_closure(pc, lib->deps[i], error) == NULL) {
+			c->requires = ARGS_EMPTY;
+			return NULL;
+		}
+	}
+	if (!combine(pc, c)) {
+		c->requires = ARGS_EMPTY;
+		c->libs = ARGS_EMPTY;
+		*error = "out of memory";
+		return NULL;
+	}
+	c->done = true;
+
+	return c;
+}
+
+static void field(struct strbuf *out, const char *name, struct string value)
+{
+	strbuf_printf(out, "%s: ", name);
+	strbuf_append(out, value);
+	strbuf_putc(out, '\n');
+}
+
+static void list(struct strbuf *out, const struct args *l, const char *sep)
+{
+	for (size_t i = 0; i < l->count; i++) {
+		if (i > 0) {
+			strbuf_printf(out, "%s", sep);
+		}
+		strbuf_append(out, atom_string(l->items[i]));
+	}
+}
+
+bool pkgconfig_render(struct pkgconfig *pc, const struct pkgconfig_info *info,
+		      struct strbuf *out, const char **error)
+{
+	const struct pkgconfig_closure *c = NULL;
+	const struct args *requires = NULL;
+	const struct args *libs = NULL;
+
+	if ((c = pkgconfig_closure(pc, info->lib, error)) == NULL) {
+		return false;
+	}
+	requires = args_get(&pc->args, c->requires);
+	libs = args_get(&pc->args, c->libs);
+
+	strbuf_append(out, CSTRING("prefix="));
+	strbuf_append(out, info->prefix);
+	strbuf_append(out, CSTRING(
+		"\n"
+		"includedir=${prefix}/include\n"
+		"libdir=${prefix}/lib\n"
+		"\n"));
+
+	field(out, "Name", info->name);
+	field(out, "Description", info->description);
+	if (!string_is_null(info->url)) {
+		field(out, "URL", info->url);
+	}
+	field(out, "Version", info->version);
+
+	if (requires->count > 0) {
+		strbuf_append(out, CSTRING("Requires.private: "));
+		list(out, requires, ", ");
+		strbuf_putc(out, '\n');
+	}
+	strbuf_append(out, CSTRING("Libs: -L${libdir} -l"));
+	strbuf_append(out, info->lib->name);
+	strbuf_putc(out, '\n');
+	if (libs->count > 0) {
+		strbuf_append(out, CSTRING("Libs.private: "));
+		list(out, libs, " ");
+		strbuf_putc(out, '\n');
+	}
+	strbuf_append(out, CSTRING("Cflags: -I${includedir}\n"));
+
+	if (out->failed) {
+		*error = "out of memory";
+		return false;
+	}
+	return true;
+}
+
+bool pkgconfig_write(struct pkgconfig *pc, const struct pkgconfig_info *info,
+		     const char *path, bool *changed, const char **error)
+{
+	struct strbuf out;
+	bool ok = false;
+
+	*changed = false;
+	strbuf_init(&out);
+	if (pkgconfig_render(pc, info, &out, error)) {
+		if (!(ok = strbuf_write_if_changed(&out, path, changed))) {
+			*error = "cannot write file";
+		}
+	}
+	strbuf_free(&out);
+
+	return ok;
+}
@@ -0,0 +1,105 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef PKGCONFIG_H
+#define PKGCONFIG_H
+
+#include "args.h"
+#include "strbuf.h"
+
+/*
+ * pkgconfig.generate().
+ *
+ * A library's .pc file lists what static linking needs: every library
+ * it reaches through link dependencies, up to libraries that have
+ * pkg-config packages of their own, which go to Requires.private
+ * instead.  Closures are interned argument lists and are computed once
+ * per library, so generating files for many libraries that share
+ * dependencies walks each dependency only once.
+ */
+
+/* A library in the dependency graph, owned by the caller. */
+struct pkgconfig_lib {
+	/* Linked as -lNAME */
+	struct string name;
+	/* Package describing this library, or null */
+	struct string package;
+	const struct pkgconfig_lib *const *deps;
+	size_t dep_count;
+};
+
+struct pkgconfig_closure {
+	const struct pkgconfig_lib *lib;
+	bool done;
+	/* Argument list ids */
+	uint32_t requires;
+	uint32_t libs;
+};
+
+struct pkgconfig {
+	struct atom_table atoms;
+	struct args_table args;
+	struct pkgconfig_closure **slots;
+	size_t capacity;
+	size_t count;
+};
+
+struct pkgconfig_info {
+	struct string name;
+	struct string description;
+	struct string version;
+	/* May be null */
+	struct string url;
+	struct string prefix;
+	const struct pkgconfig_lib *lib;
+};
+
+bool pkgconfig_init(struct pkgconfig *pc);
+void pkgconfig_free(struct pkgconfig *pc);
+
+/**
+ * \brief Dependency closure of a library
+ *
+ * Libraries are listed before the libraries they depend on, as static
+ * linking needs.
+ *
+ * Returns null and sets error on a dependency cycle or allocation
+ * failure.
+ */
+const struct pkgconfig_closure *pkgconfig_closure(struct pkgconfig *pc,
+						  const struct pkgconfig_lib *lib,
+						  const char **error);
+
+bool pkgconfig_render(struct pkgconfig *pc, const struct pkgconfig_info *info,
+		      struct strbuf *out, const char **error);
+
+/**
+ * \brief Write a .pc file unless it already has this content
+ *
+ * On failure error is set, and errno too if writing failed.
+ */
+bool pkgconfig_write(struct pkgconfig *pc, const struct pkgconfig_info *info,
+		     const char *path, bool *changed, const char **error);
+
+#endif /* PKGCONFIG_H */
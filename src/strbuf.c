@@ -0,0 +1,193 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "strbuf.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define process_id() ((long) _getpid())
+#else
+#include <unistd.h>
+#define process_id() ((long) getpid())
+#endif
+
+#define INITIAL_CAPACITY 4096
+
+void strbuf_init(struct strbuf *b)
+{
+	memset(b, 0, sizeof(*b));
+}
+
+void strbuf_free(struct strbuf *b)
+{
+	if (b->data != NULL) {
+		mem_free_tag(b->data, b->capacity, MEM_STRBUF);
+	}
+	memset(b, 0, sizeof(*b));
+}
+
+static bool reserve(struct strbuf *b, size_t length)
+{
+	size_t capacity = b->capacity ? b->capacity : INITIAL_CAPACITY;
+	char *data = NULL;
+
+	if (b->failed) {
+		return false;
+	}
+	if (b->length + length <= b->capacity) {
+		return true;
+	}
+	while (capacity < b->length + length) {
+		capacity *= 2;
+	}
+	if ((data = mem_realloc_tag(b->data, b->capacity, capacity,
+				    MEM_STRBUF)) == NULL) {
+		b->failed = true;
+		return false;
+	}
+	b->data = data;
+	b->capacity = capacity;
+
+	return true;
+}
+
+void strbuf_append_n(struct strbuf *b, const char *s, size_t length)
+{
+	if (length > 0 && reserve(b, length)) {
+		memcpy(b->data + b->length, s, length);
+		b->length += length;
+	}
+}
+
+void strbuf_append(struct strbuf *b, struct string s)
+{
+	strbuf_append_n(b, string_buffer(s), string_length(s));
+}
+
+void strbuf_putc(struct strbuf *b, char c)
+{
+	if (reserve(b, 1)) {
+		b->data[b->length++] = c;
+	}
+}
+
+void strbuf_printf(struct strbuf *b, const char *format, ...)
+{
+	va_list args;
+	int n = 0;
+
+	va_start(args, format);
+	n = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	/* Room for the terminator vsnprintf() writes. */
+	if (n < 0 || !reserve(b, (size_t) n + 1)) {
+		b->failed = true;
+		return;
+	}
+
+	va_start(args, format);
+	vsnprintf(b->data + b->length, (size_t) n + 1, format, args);
+	va_end(args);
+	b->length += n;
+}
+
+/* Tells whether the file at path holds exactly the buffer contents. */
+static bool same_contents(const struct strbuf *b, const char *path)
+{
+	struct stat st;
+	char chunk[8192];
+	size_t offset = 0;
+	size_t n = 0;
+	bool same = true;
+	FILE *f = NULL;
+
+	if (stat(path, &st) != 0 || (size_t) st.st_size != b->length) {
+		return false;
+	}
+	if ((f = fopen(path, "rb")) == NULL) {
+		return false;
+	}
+	while (same && (n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+		same = offset + n <= b->length &&
+			memcmp(b->data + offset, chunk, n) == 0;
+		offset += n;
+	}
+	same = same && !ferror(f) && offset == b->length;
+	fclose(f);
+
+	return same;
+}
+
+bool strbuf_write_if_changed(const struct strbuf *b, const char *path,
+			     bool *changed)
+{
+	char *tmp = NULL;
+	/* Room for ".<pid>.tmp" with any pid */
+	size_t length = strlen(path) + sizeof(".tmp") + 22;
+	FILE *f = NULL;
+	bool ok = false;
+	int saved = 0;
+
+	*changed = false;
+	if (b->failed) {
+		errno = ENOMEM;
+		return false;
+	}
+	if (same_contents(b, path)) {
+		return true;
+	}
+
+	if ((tmp = mem_alloc_tag(length, MEM_STRBUF)) == NULL) {
+		errno = ENOMEM;
+		return false;
+	}
+	/* The pid keeps concurrent writers of one file apart */
+	snprintf(tmp, length, "%s.%ld.tmp", path, process_id());
+
+	if ((f = fopen(tmp, "wb")) != NULL) {
+		ok = fwrite(b->data, 1, b->length, f) == b->length;
+		ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+		/* rename() does not replace existing files on Windows. */
+		if (ok) {
+			remove(path);
+		}
+#endif
+		ok = ok && rename(tmp, path) == 0;
+		if (!ok) {
+			saved = errno;
+			remove(tmp);
+			errno = saved;
+		}
+	}
+	mem_free_tag(tmp, length, MEM_STRBUF);
+
+	*changed = ok;
+	return ok;
+}
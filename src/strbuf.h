@@ -0,0 +1,74 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef STRBUF_H
+#define STRBUF_H
+
+#include "common.h"
+#include <stdarg.h>
+
+/*
+ * Growable byte buffer for generated files.
+ *
+ * Output is assembled in memory and written in one go, and only if it
+ * differs from what is already on disk, so that unchanged files keep
+ * their modification time and do not trigger rebuilds.
+ *
+ * Appending never fails visibly: on allocation failure the buffer is
+ * marked and every later operation is a no-op, strbuf_write_if_changed()
+ * then reports the error.
+ */
+
+struct strbuf {
+	char *data;
+	size_t length;
+	size_t capacity;
+	bool failed;
+};
+
+void strbuf_init(struct strbuf *b);
+void strbuf_free(struct strbuf *b);
+
+void strbuf_append(struct strbuf *b, struct string s);
+void strbuf_append_n(struct strbuf *b, const char *s, size_t length);
+void strbuf_putc(struct strbuf *b, char c);
+void strbuf_printf(struct strbuf *b, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+static inline struct string strbuf_string(const struct strbuf *b)
+{
+	return string_from_buf_n(b->data, b->length);
+}
+
+/**
+ * \brief Write the buffer to path unless the file already has this content
+ *
+ * The file is replaced through a temporary file next to it.  Returns
+ * false with errno set on failure; changed tells whether the file was
+ * written.
+ */
+bool strbuf_write_if_changed(const struct strbuf *b, const char *path,
+			     bool *changed);
+
+#endif /* STRBUF_H */
@@ -0,0 +1,454 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "toolchain.h"
+#include "fs.h"
+#include "hash.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAGIC "# meson-c toolchain cache, version 1\n"
+
+void toolchain_cache_init(struct toolchain_cache *c)
+{
+	memset(c, 0, sizeof(*c));
+}
+
+static void free_fields(struct toolchain_entry *e)
+{
+	for (size_t i = 0; i < e->count; i++) {
+		string_free(&e->fields[i].key);
+		string_free(&e->fields[i].value);
+	}
+	if (e->fields != NULL) {
+		mem_free_tag(e->fields, e->count * sizeof(*e->fields),
+			     MEM_TOOLCHAIN);
+	}
+	e->fields = NULL;
+	e->count = 0;
+}
+
+void toolchain_cache_free(struct toolchain_cache *c)
+{
+	for (size_t i = 0; i < c->count; i++) {
+		string_free(&c->entries[i].path);
+		free_fields(&c->entries[i]);
+	}
+	if (c->entries != NULL) {
+		mem_free_tag(c->entries, c->capacity * sizeof(*c->entries),
+			     MEM_TOOLCHAIN);
+	}
+	memset(c, 0, sizeof(*c));
+}
+
+/* Takes ownership of key and value, also on failure. */
+static bool add_field(struct toolchain_entry *e, struct string key,
+		      struct string value)
+{
+	struct toolchain_field *fields = NULL;
+
+	if (!key.valid || !value.valid ||
+	    (fields = mem_realloc_tag(e->fields, e->count * sizeof(*fields),
+				      (e->count + 1) * sizeof(*fields),
+				      MEM_TOOLCHAIN)) == NULL) {
+		string_free(&key);
+		string_free(&value);
+		return false;
+	}
+	fields[e->count++] = (struct toolchain_field) { key, value };
+	e->fields = fields;
+
+	return true;
+}
+
+/* Returns a new entry for path, initialized but for the fields. */
+static struct toolchain_entry *add_entry(struct toolchain_cache *c,
+					 struct string path)
+{
+	struct toolchain_entry *e = NULL;
+
+	if (c->count == c->capacity) {
+		size_t capacity = c->capacity ? c->capacity * 2 : 4;
+		struct toolchain_entry *entries = NULL;
+
+		if ((entries = mem_realloc_tag(c->entries,
+					       c->capacity * sizeof(*entries),
+					       capacity * sizeof(*entries),
+					       MEM_TOOLCHAIN)) == NULL) {
+			return NULL;
+		}
+		c->entries = entries;
+		c->capacity = capacity;
+	}
+	e = &c->entries[c->count];
+	memset(e, 0, sizeof(*e));
+	if (!(e->path = string_dup_n(string_buffer(path),
+				     string_length(path))).valid) {
+		return NULL;
+	}
+	c->count++;
+
+	return e;
+}
+
+static void remove_entry(struct toolchain_cache *c, struct toolchain_entry *e)
+{
+	size_t i = e - c->entries;
+
+	string_free(&e->path);
+	free_fields(e);
+	memmove(e, e + 1, (c->count - i - 1) * sizeof(*e));
+	c->count--;
+}
+
+static struct toolchain_entry *find(struct toolchain_cache *c,
+				    struct string path)
+{
+	for (size_t i = 0; i < c->count; i++) {
+		if (string_equal(c->entries[i].path, path)) {
+			return &c->entries[i];
+		}
+	}
+	return NULL;
+}
+
+/* Values are kept on one line: `\' and newlines are escaped. */
+static void append_escaped(struct strbuf *out, struct string s)
+{
+	const char *p = string_buffer(s);
+
+	for (size_t i = 0; i < string_length(s); i++) {
+		if (p[i] == '\\') {
+			strbuf_append(out, CSTRING("\\\\"));
+		} else if (p[i] == '\n') {
+			strbuf_append(out, CSTRING("\\n"));
+		} else {
+			strbuf_putc(out, p[i]);
+		}
+	}
+}
+
+static struct string unescape(struct string s)
+{
+	const char *p = string_buffer(s);
+	size_t n = string_length(s);
+	size_t length = n;
+	struct string result;
+	char *out = NULL;
+
+	for (size_t i = 0; i + 1 < n; i++) {
+		if (p[i] == '\\') {
+			length--;
+			i++;
+		}
+	}
+	if (!(result = string_alloc(length)).valid) {
+		return result;
+	}
+	out = string_buffer(result);
+	for (size_t i = 0; i < n; i++) {
+		if (p[i] == '\\' && i + 1 < n) {
+			i++;
+			*out++ = p[i] == 'n' ? '\n' : p[i];
+		} else {
+			*out++ = p[i];
+		}
+	}
+	return result;
+}
+
+bool toolchain_cache_save(const struct toolchain_cache *c, const char *file,
+			  bool *changed)
+{
+	struct strbuf out;
+	bool ok = false;
+
+	strbuf_init(&out);
+	strbuf_append(&out, CSTRING(MAGIC));
+	for (size_t i = 0; i < c->count; i++) {
+		const struct toolchain_entry *e = &c->entries[i];
+
+		strbuf_printf(&out, "compiler %" PRIu64 " %" PRId64 " %" PRIu64
+			      " %016" PRIx64 " ", e->size, e->mtime, e->ino,
+			      e->env);
+		append_escaped(&out, e->path);
+		strbuf_putc(&out, '\n');
+		for (size_t j = 0; j < e->count; j++) {
+			strbuf_append(&out, CSTRING("field "));
+			strbuf_append(&out, e->fields[j].key);
+			strbuf_putc(&out, ' ');
+			append_escaped(&out, e->fields[j].value);
+			strbuf_putc(&out, '\n');
+		}
+	}
+	ok = strbuf_write_if_changed(&out, file, changed);
+	strbuf_free(&out);
+
+	return ok;
+}
+
+static bool read_file(const char *file, struct strbuf *out)
+{
+	char chunk[8192];
+	size_t n = 0;
+	FILE *f = NULL;
+
+	if ((f = fopen(file, "rb")) == NULL) {
+		return false;
+	}
+	while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+		strbuf_append_n(out, chunk, n);
+	}
+	fclose(f);
+	/* Terminate for strtoull(), without counting the terminator. */
+	strbuf_putc(out, '\0');
+	out->length--;
+
+	return !out->failed;
+}
+
+/* Parses a number followed by a space at *p. */
+static bool number(const char **p, int base, bool sign, uint64_t *value)
+{
+	char *end = NULL;
+
+	if (!((**p >= '0' && **p <= '9') || (base == 16 && **p >= 'a' &&
+					     **p <= 'f') ||
+	      (sign && **p == '-'))) {
+		return false;
+	}
+	*value = sign ? (uint64_t) strtoll(*p, &end, base) :
+		strtoull(*p, &end, base);
+	if (*end != ' ') {
+		return false;
+	}
+	*p = end + 1;
+	return true;
+}
+
+static bool parse_compiler(struct toolchain_cache *c, struct string line,
+			   struct toolchain_entry **e)
+{
+	const char *p = string_buffer(line) + sizeof("compiler ") - 1;
+	const char *end = string_buffer(line) + string_length(line);
+	uint64_t size = 0, mtime = 0, ino = 0, env = 0;
+	struct string path;
+
+	if (!number(&p, 10, false, &size) || !number(&p, 10, true, &mtime) ||
+	    !number(&p, 10, false, &ino) || !number(&p, 16, false, &env) ||
+	    p >= end) {
+		return false;
+	}
+	if (!(path = unescape(string_from_buf_n(p, end - p))).valid) {
+		return false;
+	}
+	*e = add_entry(c, path);
+	string_free(&path);
+	if (*e == NULL) {
+		return false;
+	}
+	(*e)->size = size;
+	(*e)->mtime = (int64_t) mtime;
+	(*e)->ino = ino;
+	(*e)->env = env;
+
+	return true;
+}
+
+static bool parse_field(struct toolchain_entry *e, struct string line)
+{
+	struct string rest = string_slice(line, sizeof("field ") - 1,
+					  string_length(line) -
+					  (sizeof("field ") - 1));
+	size_t space = 0;
+
+	if (e == NULL || !string_find(rest, CSTRING(" "), &space) ||
+	    space == 0) {
+		return false;
+	}
+	return add_field(e, string_dup_n(string_buffer(rest), space),
+			 unescape(string_slice(rest, space + 1,
+					       string_length(rest) - space - 1)));
+}
+
+bool toolchain_cache_load(struct toolchain_cache *c, const char *file)
+{
+	struct strbuf text;
+	struct string_split it;
+	struct string line;
+	struct toolchain_entry *e = NULL;
+	bool ok = true;
+
+	toolchain_cache_free(c);
+	strbuf_init(&text);
+
+	if (!read_file(file, &text) ||
+	    !string_startswith(strbuf_string(&text), CSTRING(MAGIC))) {
+		ok = !text.failed;
+		goto out;
+	}
+	string_split_init(&it, string_slice(strbuf_string(&text),
+					    sizeof(MAGIC) - 1,
+					    text.length - (sizeof(MAGIC) - 1)),
+			  CSTRING("\n"));
+	while (ok && string_split_next(&it, &line)) {
+		if (string_length(line) == 0) {
+			continue;
+		}
+		if (string_startswith(line, CSTRING("compiler "))) {
+			ok = parse_compiler(c, line, &e);
+		} else if (string_startswith(line, CSTRING("field "))) {
+			ok = parse_field(e, line);
+		} else {
+			ok = false;
+		}
+	}
+	/* A damaged file is as good as none. */
+	if (!ok) {
+		toolchain_cache_free(c);
+		ok = true;
+	}
+out:
+	strbuf_free(&text);
+	return ok;
+}
+
+uint64_t toolchain_env_hash(const char *const *names, size_t count)
+{
+	struct strbuf text;
+	uint64_t h = 0;
+
+	strbuf_init(&text);
+	for (size_t i = 0; i < count; i++) {
+		const char *value = getenv(names[i]);
+
+		strbuf_append(&text, string_from_buf(names[i]));
+		if (value != NULL) {
+			strbuf_putc(&text, '=');
+			strbuf_append(&text, string_from_buf(value));
+		}
+		strbuf_putc(&text, '\0');
+	}
+	h = hash_xxh64(text.data, text.length, 0);
+	strbuf_free(&text);
+
+	return h;
+}
+
+static bool identity(struct string path, struct fs_stat *st)
+{
+	struct string copy = string_dup_n(string_buffer(path),
+					  string_length(path));
+
+	if (!copy.valid) {
+		return false;
+	}
+	fs_stat_path(string_buffer(copy), st);
+	string_free(&copy);
+
+	return st->exists;
+}
+
+const struct toolchain_entry *toolchain_cache_lookup(struct toolchain_cache *c,
+						     struct string path,
+						     uint64_t env)
+{
+	struct toolchain_entry *e = NULL;
+	struct fs_stat st;
+
+	if ((e = find(c, path)) == NULL || e->env != env ||
+	    !identity(path, &st)) {
+		return NULL;
+	}
+	if (st.size != e->size || st.mtime != e->mtime || st.ino != e->ino) {
+		return NULL;
+	}
+	return e;
+}
+
+/* Keys are written as is, so they must not break the line format. */
+static bool valid_key(struct string key)
+{
+	const char *p = string_buffer(key);
+
+	for (size_t i = 0; i < string_length(key); i++) {
+		if (p[i] == ' ' || p[i] == '\n' || p[i] == '\\') {
+			return false;
+		}
+	}
+	return string_length(key) > 0;
+}
+
+bool toolchain_cache_store(struct toolchain_cache *c, struct string path,
+			   uint64_t env, const struct toolchain_field *fields,
+			   size_t count)
+{
+	struct toolchain_entry *e = NULL;
+	struct fs_stat st;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!valid_key(fields[i].key)) {
+			return false;
+		}
+	}
+	if (!identity(path, &st)) {
+		return false;
+	}
+	if ((e = find(c, path)) != NULL) {
+		free_fields(e);
+	} else if ((e = add_entry(c, path)) == NULL) {
+		return false;
+	}
+	e->size = st.size;
+	e->mtime = st.mtime;
+	e->ino = st.ino;
+	e->env = env;
+
+	for (size_t i = 0; i < count; i++) {
+		struct string key = fields[i].key;
+		struct string value = fields[i].value;
+
+		if (!add_field(e, string_dup_n(string_buffer(key),
+					       string_length(key)),
+			       string_dup_n(string_buffer(value),
+					    string_length(value)))) {
+			/* Drop the entry rather than keep part of it. */
+			remove_entry(c, e);
+			return false;
+		}
+	}
+	return true;
+}
+
+struct string toolchain_entry_get(const struct toolchain_entry *e,
+				  struct string key)
+{
+	for (size_t i = 0; i < e->count; i++) {
+		if (string_equal(e->fields[i].key, key)) {
+			return e->fields[i].value;
+		}
+	}
+	return NULL_STRING;
+}
@@ -0,0 +1,114 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef TOOLCHAIN_H
+#define TOOLCHAIN_H
+
+#include "strbuf.h"
+
+/*
+ * Persistent cache of toolchain detection results.
+ *
+ * Detecting a compiler means running it several times.  The results,
+ * a list of key/value fields such as id, version, linker and include
+ * paths, are saved per compiler binary together with the binary's
+ * size, modification time and inode and a hash of the environment
+ * variables that affect detection.  A later configure run reuses them
+ * as long as none of those changed.
+ */
+
+struct toolchain_field {
+	struct string key;
+	struct string value;
+};
+
+struct toolchain_entry {
+	struct string path;
+	uint64_t size;
+	int64_t mtime;
+	uint64_t ino;
+	uint64_t env;
+	struct toolchain_field *fields;
+	size_t count;
+};
+
+struct toolchain_cache {
+	struct toolchain_entry *entries;
+	size_t count;
+	size_t capacity;
+};
+
+void toolchain_cache_init(struct toolchain_cache *c);
+void toolchain_cache_free(struct toolchain_cache *c);
+
+/**
+ * \brief Load a cache file
+ *
+ * A missing, outdated or malformed file leaves the cache empty, which
+ * only costs a new detection.  Returns false on allocation failure.
+ */
+bool toolchain_cache_load(struct toolchain_cache *c, const char *file);
+
+/**
+ * \brief Save the cache, see strbuf_write_if_changed()
+ */
+bool toolchain_cache_save(const struct toolchain_cache *c, const char *file,
+			  bool *changed);
+
+/**
+ * \brief Hash the values of the named environment variables
+ *
+ * An unset variable hashes differently from an empty one.
+ */
+uint64_t toolchain_env_hash(const char *const *names, size_t count);
+
+/**
+ * \brief Cached results for a compiler binary
+ *
+ * Returns null if there are none or if the binary or the environment
+ * changed since they were stored.
+ */
+const struct toolchain_entry *toolchain_cache_lookup(struct toolchain_cache *c,
+						     struct string path,
+						     uint64_t env);
+
+/**
+ * \brief Store results for a compiler binary, replacing older ones
+ *
+ * Keys must be non-empty and free of spaces, newlines and backslashes.
+ * Returns false if a key is invalid, if the binary cannot be stat'ed
+ * or on allocation failure; in the latter case the older results are
+ * gone too.
+ */
+bool toolchain_cache_store(struct toolchain_cache *c, struct string path,
+			   uint64_t env, const struct toolchain_field *fields,
+			   size_t count);
+
+/**
+ * \brief Value of a field of an entry, or a null string
+ */
+struct string toolchain_entry_get(const struct toolchain_entry *e,
+				  struct string key);
+
+#endif /* TOOLCHAIN_H */
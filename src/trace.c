@@ -0,0 +1,206 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "trace.h"
+#include "common.h"
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/*
+ * Events per thread; the buffer grows from TRACE_INITIAL up to
+ * TRACE_CAPACITY, then the oldest events are overwritten.
+ */
+#define TRACE_INITIAL 1024u
+#define TRACE_CAPACITY (1u << 18)
+
+struct event {
+	const char *name;
+	const char *detail;
+	uint64_t timestamp;
+	int64_t value;
+	char phase;
+};
+
+struct buffer {
+	struct buffer *next;
+	unsigned int tid;
+	size_t count;
+	/* Stays fixed once the ring wraps */
+	size_t capacity;
+	struct event *events;
+};
+
+static _Atomic(struct buffer *) buffers;
+static atomic_uint next_tid;
+static _Thread_local struct buffer *local;
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static struct buffer *get_buffer(void)
+{
+	struct buffer *b = NULL;
+
+	if (local != NULL) {
+		return local;
+	}
+	if ((b = mem_alloc_tag(sizeof(*b), MEM_TRACE)) == NULL) {
+		return NULL;
+	}
+	b->capacity = TRACE_INITIAL;
+	if ((b->events = mem_alloc_tag(b->capacity * sizeof(*b->events),
+				       MEM_TRACE)) == NULL) {
+		mem_free_tag(b, sizeof(*b), MEM_TRACE);
+		return NULL;
+	}
+	b->tid = atomic_fetch_add(&next_tid, 1) + 1;
+	b->next = atomic_load(&buffers);
+	while (!atomic_compare_exchange_weak(&buffers, &b->next, b)) {
+		continue;
+	}
+
+	return local = b;
+}
+
+static void record(char phase, const char *name,
+		   const char *detail, int64_t value)
+{
+	struct buffer *b = NULL;
+	struct event *e = NULL;
+
+	if ((b = get_buffer()) == NULL) {
+		return;
+	}
+	if (b->count == b->capacity && b->capacity < TRACE_CAPACITY) {
+		struct event *events = NULL;
+
+		/* On failure the ring just wraps at its current size. */
+		if ((events = mem_realloc_tag(b->events,
+					      b->capacity * sizeof(*events),
+					      2 * b->capacity * sizeof(*events),
+					      MEM_TRACE)) != NULL) {
+			b->events = events;
+			b->capacity *= 2;
+		}
+	}
+	e = &b->events[b->count++ % b->capacity];
+	e->name = name;
+	e->detail = detail;
+	e->timestamp = now();
+	e->value = value;
+	e->phase = phase;
+}
+
+void trace_begin(const char *name, const char *detail)
+{
+	record('B', name, detail, 0);
+}
+
+void trace_end(void)
+{
+	record('E', NULL, NULL, 0);
+}
+
+void trace_counter(const char *name, int64_t value)
+{
+	record('C', name, NULL, value);
+}
+
+static void write_string(FILE *out, const char *s)
+{
+	fputc('"', out);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fprintf(out, "\\%c", *s);
+		} else if ((unsigned char) *s < 0x20) {
+			fprintf(out, "\\u%04x", *s);
+		} else {
+			fputc(*s, out);
+		}
+	}
+	fputc('"', out);
+}
+
+static void write_event(FILE *out, unsigned int tid, const struct event *e)
+{
+	fprintf(out, "{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%" PRIu64 ".%03u",
+		e->phase, tid, e->timestamp / 1000,
+		(unsigned int) (e->timestamp % 1000));
+	if (e->name != NULL) {
+		fputs(",\"name\":", out);
+		write_string(out, e->name);
+	}
+	if (e->phase == 'C') {
+		fprintf(out, ",\"args\":{\"value\":%" PRIi64 "}", e->value);
+	} else if (e->detail != NULL) {
+		fputs(",\"args\":{\"detail\":", out);
+		write_string(out, e->detail);
+		fputc('}', out);
+	}
+	fputc('}', out);
+}
+
+bool trace_write(FILE *out)
+{
+	struct buffer *b = NULL;
+	bool first = true;
+
+	fputs("{\"traceEvents\":[", out);
+
+	for (b = atomic_load(&buffers); b != NULL; b = b->next) {
+		size_t start = 0;
+		size_t depth = 0;
+
+		if (b->count > b->capacity) {
+			start = b->count - b->capacity;
+		}
+		for (size_t i = start; i < b->count; i++) {
+			const struct event *e = &b->events[i % b->capacity];
+
+			/* Its begin event was overwritten. */
+			if (e->phase == 'E' && depth == 0) {
+				continue;
+			}
+			depth += e->phase == 'B';
+			depth -= e->phase == 'E';
+
+			if (!first) {
+				fputc(',', out);
+			}
+			fputc('\n', out);
+			write_event(out, b->tid, e);
+			first = false;
+		}
+	}
+
+	fputs("\n],\"displayTimeUnit\":\"ns\"}\n", out);
+
+	return !ferror(out);
+}
@@ -0,0 +1,70 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "defs.h"
+#include <stdio.h>
+
+/*
+ * Trace events in Chrome trace-event format.
+ *
+ * Events are recorded only when the library is built with TRACE=1
+ * (which defines ENABLE_TRACE); otherwise every macro below expands to
+ * nothing.  Names and details must be strings that outlive the trace.
+ *
+ * Each thread keeps its most recent events in a ring that grows on
+ * demand, so trace coarse spans (files, parses) rather than per-token
+ * work and report fine-grained quantities through counters.
+ */
+
+#ifdef ENABLE_TRACE
+
+void trace_begin(const char *name, const char *detail);
+void trace_end(void);
+void trace_counter(const char *name, int64_t value);
+
+/**
+ * \brief Write all recorded events as JSON
+ *
+ * Must not be called while other threads are recording events.
+ */
+bool trace_write(FILE *out);
+
+#define TRACE_BEGIN(name)		trace_begin(name, NULL)
+#define TRACE_BEGIN_DETAIL(name, detail) trace_begin(name, detail)
+#define TRACE_END()			trace_end()
+#define TRACE_COUNTER(name, value)	trace_counter(name, value)
+
+#else
+
+#define TRACE_BEGIN(name)		((void) 0)
+#define TRACE_BEGIN_DETAIL(name, detail) ((void) 0)
+#define TRACE_END()			((void) 0)
+#define TRACE_COUNTER(name, value)	((void) 0)
+
+#endif /* ENABLE_TRACE */
+
+#endif /* TRACE_H */
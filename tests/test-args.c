@@ -0,0 +1,177 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "args.h"
+#include <stdio.h>
+
+static struct atom_table atoms;
+static struct args_table table;
+
+#define ARGS(...) intern((const char *[]) { __VA_ARGS__ }, \
+	sizeof((const char *[]) { __VA_ARGS__ }) / sizeof(const char *))
+
+static uint32_t intern(const char **items, size_t count)
+{
+	struct string strings[16];
+
+	assert(count <= ARRAY_SIZE(strings));
+	for (size_t i = 0; i < count; i++) {
+		strings[i] = string_from_buf(items[i]);
+	}
+	return args_intern_strings(&table, strings, count);
+}
+
+static void setup(void)
+{
+	atom_table_init(&atoms);
+	TEST_ASSERT(args_table_init(&table, &atoms));
+}
+
+static void teardown(void)
+{
+	args_table_free(&table);
+	atom_table_free(&atoms);
+}
+
+static void test_intern(void)
+{
+	uint32_t a = ARGS_INVALID;
+	const struct args *l = NULL;
+
+	setup();
+
+	TEST_CHECK(args_intern_strings(&table, NULL, 0) == ARGS_EMPTY);
+	TEST_CHECK(args_get(&table, ARGS_EMPTY)->count == 0);
+
+	a = ARGS("-O2", "-g", "-Wall");
+	TEST_CHECK(a == 1);
+	TEST_CHECK(ARGS("-O2", "-g", "-Wall") == a);
+	TEST_CHECK(ARGS("-O2", "-Wall", "-g") == 2);
+	TEST_CHECK(ARGS("-O2", "-g") == 3);
+	TEST_CHECK(table.count == 4);
+
+	l = args_get(&table, a);
+	TEST_CHECK(l->id == a);
+	TEST_CHECK(l->count == 3);
+	TEST_CHECK(l->items[1] == atom_intern(&atoms, CSTRING("-g")));
+
+	teardown();
+}
+
+static void test_many(void)
+{
+	char arg[32];
+	uint32_t ids[500];
+
+	setup();
+
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		snprintf(arg, sizeof(arg), "-DVALUE=%zu", i);
+		ids[i] = ARGS("-O2", arg);
+		TEST_CHECK(ids[i] == i + 1);
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(ids); i++) {
+		snprintf(arg, sizeof(arg), "-DVALUE=%zu", i);
+		TEST_CHECK(ARGS("-O2", arg) == ids[i]);
+	}
+
+	teardown();
+}
+
+static void test_dedup(void)
+{
+	setup();
+
+	TEST_CHECK(args_dedup(&table, ARGS_EMPTY) == ARGS_EMPTY);
+	TEST_CHECK(args_dedup(&table, ARGS("-g")) == ARGS("-g"));
+	TEST_CHECK(args_dedup(&table, ARGS("-Ia", "-DB", "-Ia", "-c", "-DB")) ==
+		   ARGS("-Ia", "-DB", "-c"));
+	TEST_CHECK(args_dedup(&table, ARGS("-Ia", "-Ib")) == ARGS("-Ia", "-Ib"));
+	TEST_CHECK(args_dedup(&table, ARGS("-O2", "-g", "-O2")) ==
+		   ARGS("-O2", "-g", "-O2"));
+	TEST_CHECK(args_dedup(&table, ARGS("-lz", "-lm", "-lz", "libx.a",
+					   "libx.a")) ==
+		   ARGS("-lm", "-lz", "libx.a"));
+	TEST_CHECK(args_dedup(&table, ARGS("-isystem", "a", "-isystem", "b",
+					   "-isystem", "a")) ==
+		   ARGS("-isystem", "a", "-isystem", "b"));
+
+	teardown();
+}
+
+static void test_pairs(void)
+{
+	setup();
+
+	TEST_CHECK(args_dedup(&table, ARGS("-framework", "Foo",
+					   "-framework", "Bar")) ==
+		   ARGS("-framework", "Foo", "-framework", "Bar"));
+	TEST_CHECK(args_dedup(&table, ARGS("-Xlinker", "a", "-Xlinker", "b")) ==
+		   ARGS("-Xlinker", "a", "-Xlinker", "b"));
+	TEST_CHECK(args_dedup(&table, ARGS("-Xlinker", "-z", "-Xlinker", "-z")) ==
+		   ARGS("-Xlinker", "-z", "-Xlinker", "-z"));
+	TEST_CHECK(args_merge(&table, ARGS("-framework", "Foo", "-lz"),
+			      ARGS("-framework", "Bar", "-framework", "Foo")) ==
+		   ARGS("-lz", "-framework", "Bar", "-framework", "Foo"));
+	/* A value that looks like a library is not one. */
+	TEST_CHECK(args_merge(&table, ARGS("-Xlinker", "-lfoo"),
+			      ARGS("-lfoo")) ==
+		   ARGS("-Xlinker", "-lfoo", "-lfoo"));
+	/* Nor is a dangling flag paired with the next list. */
+	TEST_CHECK(args_merge(&table, ARGS("-Xlinker"), ARGS("-lz", "-lz")) ==
+		   ARGS("-Xlinker", "-lz"));
+
+	teardown();
+}
+
+static void test_merge(void)
+{
+	uint32_t own = ARGS_INVALID;
+
+	setup();
+
+	own = ARGS("-Iinc", "-DX", "-Iinc");
+	TEST_CHECK(args_merge(&table, own, ARGS_EMPTY) == own);
+	TEST_CHECK(args_merge(&table, own, own) == own);
+	TEST_CHECK(args_merge(&table, ARGS_EMPTY, ARGS("-Ia", "-Ia")) ==
+		   ARGS("-Ia"));
+	TEST_CHECK(args_merge(&table, own, ARGS("-pthread", "-DX", "-lm")) ==
+		   ARGS("-Iinc", "-DX", "-Iinc", "-pthread", "-lm"));
+	TEST_CHECK(args_merge(&table, ARGS("-lz"), ARGS("-lm", "-lz")) ==
+		   ARGS("-lm", "-lz"));
+	TEST_CHECK(args_merge(&table, ARGS("-lfoo", "-lz"), ARGS("-lbar")) ==
+		   ARGS("-lfoo", "-lz", "-lbar"));
+
+	teardown();
+}
+
+TEST_LIST = {
+	{ "interning", test_intern },
+	{ "many lists", test_many },
+	{ "deduplication", test_dedup },
+	{ "flags with values", test_pairs },
+	{ "order-preserving merge", test_merge },
+	{ NULL, NULL }
+};
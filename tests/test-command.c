@@ -0,0 +1,255 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "command.h"
+#include <stdio.h>
+
+#define ARGV(...) (const struct string[]) { __VA_ARGS__ }
+#define ARGC(...) (sizeof(ARGV(__VA_ARGS__)) / sizeof(struct string))
+#define COMPILE(...) command_compile(ARGV(__VA_ARGS__), ARGC(__VA_ARGS__))
+
+static bool args_are(const struct string *args, size_t count,
+		     const char *expected)
+{
+	char buffer[512];
+	size_t n = 0;
+
+	for (size_t i = 0; i < count && n < sizeof(buffer); i++) {
+		n += snprintf(buffer + n, sizeof(buffer) - n, "%s[%.*s]",
+			      i > 0 ? " " : "",
+			      (int) string_length(args[i]),
+			      string_buffer(args[i]));
+	}
+	buffer[n < sizeof(buffer) ? n : sizeof(buffer) - 1] = '\0';
+	TEST_MSG("got `%s', expected `%s'", buffer, expected);
+
+	return strcmp(buffer, expected) == 0;
+}
+
+static bool line_is(const struct command_line *line, const char *expected)
+{
+	if (line == NULL) {
+		TEST_MSG("expansion failed");
+		return false;
+	}
+	return args_are(line->args, line->count, expected);
+}
+
+static void test_compile(void)
+{
+	struct command_template *t = NULL;
+
+	t = COMPILE(CSTRING("protoc"), CSTRING("@INPUT@"),
+		    CSTRING("--cpp_out=@OUTDIR@"), CSTRING("-o"),
+		    CSTRING("@OUTPUT0@"), CSTRING("a@b"), CSTRING("@FOO@"));
+	TEST_ASSERT(t != NULL);
+	TEST_CHECK(t->count == 7);
+	TEST_CHECK(t->fixed == 6);
+	TEST_CHECK(t->args[0].kind == COMMAND_ARG_LITERAL);
+	TEST_CHECK(t->args[1].kind == COMMAND_ARG_LIST);
+	TEST_CHECK(t->args[1].var == COMMAND_INPUT);
+	TEST_CHECK(t->args[2].kind == COMMAND_ARG_SEGMENTS);
+	TEST_CHECK(t->args[2].count == 2);
+	TEST_CHECK(t->args[4].kind == COMMAND_ARG_SEGMENTS);
+	TEST_CHECK(t->args[5].kind == COMMAND_ARG_LITERAL);
+	TEST_CHECK(t->args[6].kind == COMMAND_ARG_LITERAL);
+	TEST_CHECK(t->uses == (COMMAND_VAR_BIT(COMMAND_INPUT) |
+			       COMMAND_VAR_BIT(COMMAND_OUTPUT) |
+			       COMMAND_VAR_BIT(COMMAND_OUTDIR)));
+	command_template_free(t);
+}
+
+static void test_expand(void)
+{
+	const struct string inputs[] = { CSTRING("a.proto"), CSTRING("b.proto") };
+	const struct string outputs[] = { CSTRING("a.pb.cc"), CSTRING("a.pb.h") };
+	const struct string outdir = CSTRING("gen");
+	struct command_env env = { 0 };
+	struct command_template *t = NULL;
+	struct command_line *line = NULL;
+	const char *error = NULL;
+
+	command_env_set(&env, COMMAND_INPUT, inputs, 2);
+	command_env_set(&env, COMMAND_OUTPUT, outputs, 2);
+	command_env_set(&env, COMMAND_OUTDIR, &outdir, 1);
+
+	t = COMPILE(CSTRING("protoc"), CSTRING("@INPUT@"),
+		    CSTRING("--out=@OUTDIR@/@OUTPUT1@"), CSTRING("@EXTRA_ARGS@"),
+		    CSTRING("@OUTDIR@"));
+	TEST_ASSERT(t != NULL);
+
+	line = command_expand(t, &env, &error);
+	TEST_CHECK(line_is(line, "[protoc] [a.proto] [b.proto] "
+			   "[--out=gen/a.pb.h] [gen]"));
+	TEST_CHECK(string_buffer(line->args[2])[string_length(line->args[2])]
+		   == '\0');
+	command_line_free(line);
+	command_template_free(t);
+}
+
+static void test_errors(void)
+{
+	const struct string inputs[] = { CSTRING("a.c"), CSTRING("b.c") };
+	struct command_env env = { 0 };
+	struct command_template *t = NULL;
+	const char *error = NULL;
+
+	command_env_set(&env, COMMAND_INPUT, inputs, 2);
+
+	TEST_ASSERT((t = COMPILE(CSTRING("-i@INPUT@"))) != NULL);
+	TEST_CHECK(command_expand(t, &env, &error) == NULL);
+	TEST_CHECK(strstr(error, "more than one item") != NULL);
+	command_template_free(t);
+
+	TEST_ASSERT((t = COMPILE(CSTRING("@INPUT2@"))) != NULL);
+	TEST_CHECK(command_expand(t, &env, &error) == NULL);
+	TEST_CHECK(strstr(error, "out of range") != NULL);
+	command_template_free(t);
+
+	TEST_ASSERT((t = COMPILE(CSTRING("-o@OUTPUT@"))) != NULL);
+	TEST_CHECK(command_expand(t, &env, &error) == NULL);
+	TEST_CHECK(strstr(error, "empty list") != NULL);
+	command_template_free(t);
+}
+
+static void test_input_names(void)
+{
+	struct string plain;
+	struct string base;
+
+	command_input_names(CSTRING("src/proto/msg.pb.proto"), &plain, &base);
+	TEST_CHECK(string_equal(plain, CSTRING("msg.pb.proto")));
+	TEST_CHECK(string_equal(base, CSTRING("msg.pb")));
+
+	command_input_names(CSTRING("README"), &plain, &base);
+	TEST_CHECK(string_equal(plain, CSTRING("README")));
+	TEST_CHECK(string_equal(base, CSTRING("README")));
+
+	command_input_names(CSTRING("dir/.hidden"), &plain, &base);
+	TEST_CHECK(string_equal(plain, CSTRING(".hidden")));
+	TEST_CHECK(string_equal(base, CSTRING(".hidden")));
+}
+
+static void test_generator(void)
+{
+	struct command_template *t = NULL;
+	struct command_env env = { 0 };
+	struct string input = CSTRING("src/parser.y");
+	struct string dir = CSTRING("gen");
+	struct string plain;
+	struct string base;
+	struct command_line *line = NULL;
+	const char *error = NULL;
+
+	t = COMPILE(CSTRING("bison"), CSTRING("@INPUT@"),
+		    CSTRING("--defines=@BUILD_DIR@/@BASENAME@.h"),
+		    CSTRING("-o"), CSTRING("@BUILD_DIR@/@PLAINNAME@.c"));
+	TEST_ASSERT(t != NULL);
+
+	command_input_names(input, &plain, &base);
+	command_env_set(&env, COMMAND_INPUT, &input, 1);
+	command_env_set(&env, COMMAND_PLAINNAME, &plain, 1);
+	command_env_set(&env, COMMAND_BASENAME, &base, 1);
+	command_env_set(&env, COMMAND_BUILD_DIR, &dir, 1);
+
+	line = command_expand(t, &env, &error);
+	TEST_CHECK(line_is(line, "[bison] [src/parser.y] "
+			   "[--defines=gen/parser.h] [-o] [gen/parser.y.c]"));
+	command_line_free(line);
+	command_template_free(t);
+}
+
+static void test_batch(void)
+{
+	const struct string inputs[] = {
+		CSTRING("proto/a.proto"), CSTRING("proto/sub/b.proto"),
+		CSTRING("c.proto")
+	};
+	const struct string dir = CSTRING("gen");
+	const struct string extra = CSTRING("-Iproto");
+	struct command_template *t = NULL;
+	struct command_template *outputs = NULL;
+	struct command_batch *batch = NULL;
+	struct command_env env = { 0 };
+	const char *error = NULL;
+	const char *expected[] = {
+		"[protoc] [-Iproto] [--cpp_out=gen] [proto/a.proto] "
+			"[-d] [gen/a.pb.cc.d]",
+		"[protoc] [-Iproto] [--cpp_out=gen] [proto/sub/b.proto] "
+			"[-d] [gen/b.pb.cc.d]",
+		"[protoc] [-Iproto] [--cpp_out=gen] [c.proto] "
+			"[-d] [gen/c.pb.cc.d]",
+	};
+
+	t = COMPILE(CSTRING("protoc"), CSTRING("@EXTRA_ARGS@"),
+		    CSTRING("--cpp_out=@BUILD_DIR@"), CSTRING("@INPUT@"),
+		    CSTRING("-d"), CSTRING("@BUILD_DIR@/@OUTPUT0@.d"));
+	outputs = COMPILE(CSTRING("@BASENAME@.pb.cc"),
+			  CSTRING("@BASENAME@.pb.h"));
+	TEST_ASSERT(t != NULL && outputs != NULL);
+
+	command_env_set(&env, COMMAND_BUILD_DIR, &dir, 1);
+	command_env_set(&env, COMMAND_EXTRA_ARGS, &extra, 1);
+
+	batch = command_expand_batch(t, outputs, &env, inputs,
+				     ARRAY_SIZE(inputs), &error);
+	TEST_ASSERT(batch != NULL);
+	TEST_CHECK(batch->count == ARRAY_SIZE(inputs));
+
+	for (size_t i = 0; i < batch->count; i++) {
+		const struct command_edge *edge = &batch->edges[i];
+
+		TEST_CHECK(string_equal(edge->input, inputs[i]));
+		TEST_CHECK(edge->output_count == 2);
+		TEST_CHECK(string_endswith(edge->outputs[1], CSTRING(".pb.h")));
+		TEST_CHECK(args_are(edge->args, edge->count, expected[i]));
+	}
+	command_batch_free(batch);
+
+	/* Errors in any input fail the whole batch. */
+	command_template_free(t);
+	TEST_ASSERT((t = COMPILE(CSTRING("@OUTPUT2@"))) != NULL);
+	TEST_CHECK(command_expand_batch(t, outputs, &env, inputs,
+					ARRAY_SIZE(inputs), &error) == NULL);
+	TEST_CHECK(strstr(error, "out of range") != NULL);
+
+	batch = command_expand_batch(t, outputs, &env, NULL, 0, &error);
+	TEST_ASSERT(batch != NULL);
+	TEST_CHECK(batch->count == 0);
+	command_batch_free(batch);
+
+	command_template_free(outputs);
+	command_template_free(t);
+}
+
+TEST_LIST = {
+	{ "compilation", test_compile },
+	{ "expansion", test_expand },
+	{ "expansion errors", test_errors },
+	{ "input names", test_input_names },
+	{ "generator commands", test_generator },
+	{ "batched generator expansion", test_batch },
+	{ NULL, NULL }
+};
@@ -0,0 +1,53 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "../bench/compare.h"
+
+static void test_threshold(void)
+{
+	/* Clearly slower or faster. */
+	TEST_CHECK(compare_verdict(20, 2, 5) == COMPARE_REGRESSION);
+	TEST_CHECK(compare_verdict(-20, 2, 5) == COMPARE_IMPROVEMENT);
+	TEST_CHECK(compare_verdict(3, 0.5, 5) == COMPARE_SAME);
+	TEST_CHECK(compare_verdict(0, 0, 0) == COMPARE_SAME);
+}
+
+static void test_noise(void)
+{
+	/* Above the threshold, but the interval reaches below it. */
+	TEST_CHECK(compare_verdict(6, 4, 5) == COMPARE_SAME);
+	TEST_CHECK(compare_verdict(-6, 4, 5) == COMPARE_SAME);
+	/* An interval reaching down to 2% is not enough. */
+	TEST_CHECK(compare_verdict(7, 5, 5) == COMPARE_SAME);
+	/* The whole interval lies beyond the threshold. */
+	TEST_CHECK(compare_verdict(10, 4, 5) == COMPARE_REGRESSION);
+	TEST_CHECK(compare_verdict(-10, 4, 5) == COMPARE_IMPROVEMENT);
+}
+
+TEST_LIST = {
+	{ "threshold", test_threshold },
+	{ "confidence interval", test_noise },
+	{ NULL, NULL }
+};
@@ -0,0 +1,228 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HEADER \
+	"/*\n" \
+	" * Autogenerated by the Meson build system.\n" \
+	" * Do not edit, your changes will be lost.\n" \
+	" */\n" \
+	"\n" \
+	"#pragma once\n" \
+	"\n"
+
+static bool renders_to(const struct config_data *cd, const char *expected)
+{
+	struct strbuf out;
+	bool pass = false;
+
+	strbuf_init(&out);
+	config_header_render(cd, &out);
+	pass = !out.failed &&
+		string_equal(strbuf_string(&out), string_from_buf(expected));
+	TEST_MSG("got:\n%.*s", (int) out.length, out.data);
+	strbuf_free(&out);
+
+	return pass;
+}
+
+static bool file_is(const char *path, const char *expected)
+{
+	char buffer[1024];
+	size_t n = 0;
+	FILE *f = NULL;
+
+	if ((f = fopen(path, "rb")) == NULL) {
+		return false;
+	}
+	n = fread(buffer, 1, sizeof(buffer), f);
+	fclose(f);
+
+	return n == strlen(expected) && memcmp(buffer, expected, n) == 0;
+}
+
+static void test_set(void)
+{
+	struct config_data cd;
+	const struct config_entry *e = NULL;
+
+	config_data_init(&cd);
+
+	TEST_CHECK(config_data_get(&cd, CSTRING("A")) == NULL);
+	TEST_CHECK(config_data_set(&cd, CSTRING("A"), CSTRING("1"),
+				   NULL_STRING));
+	TEST_CHECK(config_data_set_bool(&cd, CSTRING("B"), false,
+					NULL_STRING));
+	TEST_CHECK(config_data_set(&cd, CSTRING("A"), CSTRING("2"),
+				   CSTRING("replaced")));
+
+	TEST_CHECK(cd.count == 2);
+	TEST_ASSERT((e = config_data_get(&cd, CSTRING("A"))) != NULL);
+	TEST_CHECK(e == &cd.entries[0]);
+	TEST_CHECK(string_equal(e->value, CSTRING("2")));
+	TEST_CHECK(string_equal(e->description, CSTRING("replaced")));
+	TEST_ASSERT((e = config_data_get(&cd, CSTRING("B"))) != NULL);
+	TEST_CHECK(e->kind == CONFIG_UNDEF);
+
+	config_data_free(&cd);
+}
+
+static void test_many(void)
+{
+	struct config_data cd;
+	char name[32];
+
+	config_data_init(&cd);
+
+	for (int i = 0; i < 3000; i++) {
+		snprintf(name, sizeof(name), "HAVE_FEATURE_%d", i);
+		TEST_CHECK(config_data_set_number(&cd, string_from_buf(name),
+						  i, NULL_STRING));
+	}
+	TEST_CHECK(cd.count == 3000);
+
+	for (int i = 0; i < 3000; i += 7) {
+		const struct config_entry *e = NULL;
+		char value[16];
+
+		snprintf(name, sizeof(name), "HAVE_FEATURE_%d", i);
+		snprintf(value, sizeof(value), "%d", i);
+		e = config_data_get(&cd, string_from_buf(name));
+		TEST_CHECK(e != NULL &&
+			   string_equal(e->value, string_from_buf(value)));
+	}
+
+	config_data_free(&cd);
+}
+
+static void test_render(void)
+{
+	struct config_data cd;
+
+	config_data_init(&cd);
+	TEST_CHECK(renders_to(&cd, HEADER));
+
+	config_data_set_quoted(&cd, CSTRING("VERSION"), CSTRING("1.0 \"x\\y\""),
+			       NULL_STRING);
+	config_data_set_bool(&cd, CSTRING("HAVE_FOO"), true,
+			     CSTRING("Define if foo is available"));
+	config_data_set_bool(&cd, CSTRING("HAVE_BAR"), false, NULL_STRING);
+	config_data_set_number(&cd, CSTRING("LEVEL"), -3, NULL_STRING);
+	config_data_set(&cd, CSTRING("HAVE_FOO_H"), CSTRING("1"), NULL_STRING);
+
+	TEST_CHECK(renders_to(&cd, HEADER
+		"#undef HAVE_BAR\n\n"
+		"/* Define if foo is available */\n"
+		"#define HAVE_FOO\n\n"
+		"#define HAVE_FOO_H 1\n\n"
+		"#define LEVEL -3\n\n"
+		"#define VERSION \"1.0 \\\"x\\\\y\\\"\"\n\n"));
+
+	config_data_free(&cd);
+}
+
+static void test_order(void)
+{
+	struct config_data a;
+	struct config_data b;
+	struct strbuf x;
+	struct strbuf y;
+
+	config_data_init(&a);
+	config_data_init(&b);
+	strbuf_init(&x);
+	strbuf_init(&y);
+
+	config_data_set(&a, CSTRING("ONE"), CSTRING("1"), NULL_STRING);
+	config_data_set(&a, CSTRING("TWO"), CSTRING("2"), NULL_STRING);
+	config_data_set(&b, CSTRING("TWO"), CSTRING("2"), NULL_STRING);
+	config_data_set(&b, CSTRING("ONE"), CSTRING("1"), NULL_STRING);
+
+	config_header_render(&a, &x);
+	config_header_render(&b, &y);
+	TEST_CHECK(string_equal(strbuf_string(&x), strbuf_string(&y)));
+
+	strbuf_free(&x);
+	strbuf_free(&y);
+	config_data_free(&a);
+	config_data_free(&b);
+}
+
+static size_t count_entries(const char *dir)
+{
+	struct dirent *e = NULL;
+	size_t n = 0;
+	DIR *d = NULL;
+
+	TEST_ASSERT((d = opendir(dir)) != NULL);
+	while ((e = readdir(d)) != NULL) {
+		n += strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0;
+	}
+	closedir(d);
+
+	return n;
+}
+
+static void test_write_if_changed(void)
+{
+	const char *path = NULL;
+	struct config_data cd;
+	bool changed = false;
+
+	test_dir_setup();
+	path = test_path("config.h");
+
+	config_data_init(&cd);
+	config_data_set(&cd, CSTRING("A"), CSTRING("1"), NULL_STRING);
+
+	TEST_CHECK(config_header_write(&cd, path, &changed));
+	TEST_CHECK(changed);
+	TEST_CHECK(file_is(path, HEADER "#define A 1\n\n"));
+
+	TEST_CHECK(config_header_write(&cd, path, &changed));
+	TEST_CHECK(!changed);
+
+	config_data_set(&cd, CSTRING("A"), CSTRING("2"), NULL_STRING);
+	TEST_CHECK(config_header_write(&cd, path, &changed));
+	TEST_CHECK(changed);
+	TEST_CHECK(file_is(path, HEADER "#define A 2\n\n"));
+	/* No temporary file is left behind */
+	TEST_CHECK(count_entries(test_dir) == 1);
+
+	config_data_free(&cd);
+	test_dir_teardown();
+}
+
+TEST_LIST = {
+	{ "set and get", test_set },
+	{ "many entries", test_many },
+	{ "header contents", test_render },
+	{ "stable order", test_order },
+	{ "write if changed", test_write_if_changed },
+	{ NULL, NULL }
+};
@@ -0,0 +1,109 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include <sys/wait.h>
+
+/* Runs the driver, returns its exit status and output. */
+static int run(const char *args, char *output, size_t size)
+{
+	char command[1024];
+	size_t n = 0;
+	FILE *p = NULL;
+	int status = 0;
+
+	snprintf(command, sizeof(command), "%s %s 2>&1", MESON_C, args);
+	TEST_ASSERT((p = popen(command, "r")) != NULL);
+	n = fread(output, 1, size - 1, p);
+	output[n] = '\0';
+	status = pclose(p);
+	TEST_ASSERT(WIFEXITED(status));
+
+	return WEXITSTATUS(status);
+}
+
+static void test_errors(void)
+{
+	char args[512];
+	char expected[512];
+	char output[1024];
+
+	test_dir_setup();
+	test_write_file("good.build", "a = 1\n");
+	test_write_file("bad.build", "a = 1\nb = [1,\n  2 )\n");
+
+	snprintf(args, sizeof(args), "parse %s", test_path("good.build"));
+	snprintf(expected, sizeof(expected), "%s: ok\n",
+		 test_path("good.build"));
+	TEST_CHECK(run(args, output, sizeof(output)) == 0);
+	TEST_CHECK(strcmp(output, expected) == 0);
+	TEST_MSG("got:\n%s", output);
+
+	snprintf(args, sizeof(args), "parse %s", test_path("bad.build"));
+	snprintf(expected, sizeof(expected),
+		 "%s:3:5: error: array: expected closing bracket\n",
+		 test_path("bad.build"));
+	TEST_CHECK(run(args, output, sizeof(output)) == 1);
+	TEST_CHECK(strcmp(output, expected) == 0);
+	TEST_MSG("got:\n%s", output);
+
+	snprintf(args, sizeof(args), "check %s", test_path("good.build"));
+	TEST_CHECK(run(args, output, sizeof(output)) == 0);
+	TEST_CHECK(strcmp(output, "") == 0);
+
+	snprintf(args, sizeof(args), "check %s", test_path("bad.build"));
+	snprintf(expected, sizeof(expected),
+		 "%s:3:5: error: array: expected closing bracket\n",
+		 test_path("bad.build"));
+	TEST_CHECK(run(args, output, sizeof(output)) == 1);
+	TEST_CHECK(strcmp(output, expected) == 0);
+	TEST_MSG("got:\n%s", output);
+
+	test_dir_teardown();
+}
+
+static void test_dump(void)
+{
+	char args[512];
+	char output[1024];
+
+	test_dir_setup();
+	test_write_file("good.build", "a = 1\n");
+
+	snprintf(args, sizeof(args), "dump-ast %s", test_path("good.build"));
+	TEST_CHECK(run(args, output, sizeof(output)) == 0);
+	TEST_CHECK(strcmp(output, "SEQUENCE\n"
+			  "  ASSIGNMENT =\n"
+			  "    ID a\n"
+			  "    NUMBER 1\n") == 0);
+	TEST_MSG("got:\n%s", output);
+
+	test_dir_teardown();
+}
+
+TEST_LIST = {
+	{ "parse errors", test_errors },
+	{ "syntax trees", test_dump },
+	{ NULL, NULL }
+};
@@ -0,0 +1,152 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "common.h"
+#include "format.h"
+#include "parser.h"
+
+static bool formats_to(const char *template, const char *expected,
+		       const struct string *args, size_t count)
+{
+	struct format *f = NULL;
+	struct string s;
+	bool pass = false;
+
+	if ((f = format_compile(string_from_buf(template))) == NULL) {
+		TEST_MSG("failed to compile `%s'", template);
+		return false;
+	}
+	s = format_apply(f, args, count);
+	pass = !string_is_null(s) &&
+		string_equal(s, string_from_buf(expected));
+	TEST_MSG("`%s': got `%.*s', expected `%s'", template,
+		 (int) string_length(s), string_buffer(s), expected);
+
+	string_free(&s);
+	format_free(f);
+	return pass;
+}
+
+static void test_apply(void)
+{
+	const struct string args[] = {
+		CSTRING("src"), CSTRING("main"), CSTRING("")
+	};
+
+	TEST_CHECK(formats_to("", "", args, 0));
+	TEST_CHECK(formats_to("plain", "plain", args, 0));
+	TEST_CHECK(formats_to("@0@", "src", args, 1));
+	TEST_CHECK(formats_to("@0@/@1@.c", "src/main.c", args, 2));
+	TEST_CHECK(formats_to("@1@@0@@1@", "mainsrcmain", args, 2));
+	TEST_CHECK(formats_to("[@2@]", "[]", args, 3));
+	TEST_CHECK(formats_to("@01@", "main", args, 2));
+}
+
+static void test_literal_at(void)
+{
+	const struct string args[] = { CSTRING("x") };
+
+	TEST_CHECK(formats_to("@", "@", args, 0));
+	TEST_CHECK(formats_to("@@", "@@", args, 0));
+	TEST_CHECK(formats_to("a@b", "a@b", args, 0));
+	TEST_CHECK(formats_to("@0", "@0", args, 0));
+	TEST_CHECK(formats_to("@@0@", "@x", args, 1));
+	TEST_CHECK(formats_to("me@host: @0@", "me@host: x", args, 1));
+}
+
+static void test_segments(void)
+{
+	struct format *f = NULL;
+
+	TEST_ASSERT((f = format_compile(CSTRING("a@b/@1@-@0@@"))) != NULL);
+	TEST_CHECK(f->count == 5);
+	TEST_CHECK(f->args == 2);
+	TEST_CHECK(f->literal_length == 6);
+	TEST_CHECK(f->segments[0].arg == FORMAT_LITERAL);
+	TEST_CHECK(f->segments[0].length == 4);
+	TEST_CHECK(memcmp(f->segments[0].text, "a@b/", 4) == 0);
+	TEST_CHECK(f->segments[1].arg == 1);
+	TEST_CHECK(f->segments[3].arg == 0);
+	TEST_CHECK(f->segments[4].length == 1);
+	format_free(f);
+}
+
+static void test_out_of_range(void)
+{
+	const struct string args[] = { CSTRING("x") };
+	struct format *f = NULL;
+	struct string s;
+
+	TEST_ASSERT((f = format_compile(CSTRING("@0@ @1@"))) != NULL);
+	TEST_CHECK(f->args == 2);
+	s = format_apply(f, args, 1);
+	TEST_CHECK(string_is_null(s));
+	format_free(f);
+
+	TEST_ASSERT((f = format_compile(CSTRING("@99999999999999@"))) != NULL);
+	TEST_CHECK(f->args == FORMAT_LITERAL);
+	s = format_apply(f, args, 1);
+	TEST_CHECK(string_is_null(s));
+	format_free(f);
+}
+
+static void test_from_ast(void)
+{
+	const struct string args[] = { CSTRING("1.2.3") };
+	struct parse_result res;
+	struct list_node *it = NULL;
+	struct ast_seq *seq = NULL;
+	struct ast_member *member = NULL;
+	struct ast_app *app = NULL;
+	struct format *f = NULL;
+	struct string s;
+
+	res = parse(CSTRING("'v@0@'.format(version)"));
+	TEST_ASSERT(res.success);
+	TEST_ASSERT((seq = ast_as(res.ast, AST_SEQUENCE)) != NULL);
+	app = ast_as(list_enum(&seq->exps, &it), AST_APPLICATION);
+	TEST_ASSERT(app != NULL);
+	TEST_ASSERT((member = ast_as(app->ref, AST_MEMBER)) != NULL);
+
+	TEST_CHECK(format_compile_ast(app->ref) == NULL);
+	TEST_ASSERT((f = format_compile_ast(member->obj)) != NULL);
+	parse_result_free(&res);
+
+	/* The template is copied, the AST is gone by now. */
+	s = format_apply(f, args, 1);
+	TEST_CHECK(string_equal(s, CSTRING("v1.2.3")));
+
+	string_free(&s);
+	format_free(f);
+}
+
+TEST_LIST = {
+	{ "formatting", test_apply },
+	{ "literal at signs", test_literal_at },
+	{ "segments", test_segments },
+	{ "out of range placeholders", test_out_of_range },
+	{ "templates from string literals", test_from_ast },
+	{ NULL, NULL }
+};
@@ -0,0 +1,198 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "fs.h"
+#include <errno.h>
+#include <unistd.h>
+
+static struct string path(const char *name)
+{
+	return string_from_buf(test_path(name));
+}
+
+static void setup(void)
+{
+	test_dir_setup();
+	test_write_file("a.txt", "abc");
+	test_write_file("empty", "");
+	TEST_ASSERT(mkdir(test_path("sub"), 0755) == 0);
+	TEST_ASSERT(symlink("a.txt", test_path("link")) == 0);
+}
+
+static void test_stat(void)
+{
+	struct fs_cache c;
+	const struct fs_stat *st = NULL;
+
+	setup();
+	fs_cache_init(&c);
+
+	TEST_CHECK(fs_exists(&c, path("a.txt")));
+	TEST_CHECK(fs_is_file(&c, path("a.txt")));
+	TEST_CHECK(!fs_is_dir(&c, path("a.txt")));
+	TEST_CHECK(fs_is_dir(&c, path("sub")));
+	TEST_CHECK(!fs_exists(&c, path("missing")));
+	TEST_CHECK(fs_is_symlink(&c, path("link")));
+	TEST_CHECK(fs_is_file(&c, path("link")));
+	TEST_CHECK(!fs_is_symlink(&c, path("a.txt")));
+
+	st = fs_stat(&c, path("a.txt"));
+	TEST_ASSERT(st != NULL);
+	TEST_CHECK(st->size == 3);
+	TEST_CHECK(fs_stat(&c, path("a.txt")) == st);
+	TEST_CHECK(c.count == 4);
+
+	/* Cached: a removed file still looks present. */
+	remove(test_path("a.txt"));
+	TEST_CHECK(fs_exists(&c, path("a.txt")));
+
+	fs_cache_free(&c);
+	test_dir_teardown();
+}
+
+static void test_read(void)
+{
+	struct fs_cache c;
+	struct string contents;
+	struct string again;
+
+	setup();
+	fs_cache_init(&c);
+
+	TEST_ASSERT(fs_read(&c, path("a.txt"), &contents));
+	TEST_CHECK(string_equal(contents, CSTRING("abc")));
+	TEST_ASSERT(fs_read(&c, path("a.txt"), &again));
+	TEST_CHECK(string_buffer(again) == string_buffer(contents));
+
+	TEST_ASSERT(fs_read(&c, path("empty"), &contents));
+	TEST_CHECK(string_length(contents) == 0);
+
+	TEST_CHECK(!fs_read(&c, path("missing"), &contents));
+	TEST_CHECK(errno == ENOENT);
+	TEST_CHECK(!fs_read(&c, path("sub"), &contents));
+	TEST_CHECK(errno == EISDIR);
+
+	fs_cache_free(&c);
+	test_dir_teardown();
+}
+
+static void test_read_sizes(void)
+{
+	struct fs_cache c;
+	struct string contents;
+	static char large[256 * 1024];
+
+	setup();
+	fs_cache_init(&c);
+
+	/* Grown since it was stat'ed. */
+	TEST_CHECK(fs_stat(&c, path("empty"))->size == 0);
+	test_write_file("empty", "later");
+	TEST_ASSERT(fs_read(&c, path("empty"), &contents));
+	TEST_CHECK(string_equal(contents, CSTRING("later")));
+
+	memset(large, 'x', sizeof(large) - 1);
+	test_write_file("large", large);
+	TEST_ASSERT(fs_read(&c, path("large"), &contents));
+	TEST_CHECK(string_length(contents) == sizeof(large) - 1);
+	TEST_CHECK(string_buffer(contents)[sizeof(large) - 2] == 'x');
+
+#ifdef __linux__
+	/* Reports a size of zero. */
+	TEST_ASSERT(fs_read(&c, CSTRING("/proc/self/status"), &contents));
+	TEST_CHECK(string_startswith(contents, CSTRING("Name:")));
+#endif
+
+	fs_cache_free(&c);
+	test_dir_teardown();
+}
+
+static void test_hash(void)
+{
+	struct fs_cache c;
+	char hex[2 * HASH_MAX_SIZE + 1];
+
+	setup();
+	fs_cache_init(&c);
+
+	TEST_CHECK(fs_hash(&c, path("a.txt"), HASH_md5, hex));
+	TEST_CHECK(strcmp(hex, "900150983cd24fb0d6963f7d28e17f72") == 0);
+	TEST_CHECK(fs_hash(&c, path("a.txt"), HASH_sha256, hex));
+	TEST_CHECK(strcmp(hex, "ba7816bf8f01cfea414140de5dae2223"
+			  "b00361a396177a9cb410ff61f20015ad") == 0);
+	TEST_CHECK(fs_hash(&c, path("link"), HASH_xxh64, hex));
+	TEST_CHECK(strcmp(hex, "44bc2cf5ad770999") == 0);
+	TEST_CHECK(fs_hash(&c, path("empty"), HASH_xxh64, hex));
+	TEST_CHECK(strcmp(hex, "ef46db3751d8e999") == 0);
+	TEST_CHECK(!fs_hash(&c, path("missing"), HASH_md5, hex));
+
+	fs_cache_free(&c);
+	test_dir_teardown();
+}
+
+static void test_inputs(void)
+{
+	struct fs_cache c;
+	struct strbuf record;
+	bool changed = true;
+
+	setup();
+	fs_cache_init(&c);
+	strbuf_init(&record);
+
+	fs_exists(&c, path("a.txt"));
+	fs_exists(&c, path("missing"));
+	fs_is_dir(&c, path("sub"));
+	fs_inputs_write(&c, &record);
+	fs_cache_free(&c);
+
+	TEST_CHECK(fs_inputs_check(strbuf_string(&record), &changed));
+	TEST_CHECK(!changed);
+
+	test_write_file("missing", "");
+	TEST_CHECK(fs_inputs_check(strbuf_string(&record), &changed));
+	TEST_CHECK(changed);
+	remove(test_path("missing"));
+
+	test_write_file("a.txt", "abcd");
+	TEST_CHECK(fs_inputs_check(strbuf_string(&record), &changed));
+	TEST_CHECK(changed);
+
+	TEST_CHECK(fs_inputs_check(CSTRING(""), &changed) && !changed);
+	TEST_CHECK(!fs_inputs_check(CSTRING("1 x 0 0 /tmp\n"), &changed));
+	TEST_CHECK(!fs_inputs_check(CSTRING("1 0 0 0 \n"), &changed));
+
+	strbuf_free(&record);
+	test_dir_teardown();
+}
+
+TEST_LIST = {
+	{ "cached metadata", test_stat },
+	{ "file reads", test_read },
+	{ "unusual sizes", test_read_sizes },
+	{ "file hashes", test_hash },
+	{ "recorded inputs", test_inputs },
+	{ NULL, NULL }
+};
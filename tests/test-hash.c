@@ -0,0 +1,102 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "hash.h"
+
+static bool digest_is(enum hash_algorithm algorithm, const char *data,
+		      const char *expected)
+{
+	uint8_t digest[HASH_MAX_SIZE];
+	char hex[2 * HASH_MAX_SIZE + 1];
+	size_t size = 0;
+
+	size = hash_digest(algorithm, data, strlen(data), digest);
+	hash_hex(digest, size, hex);
+	TEST_MSG("`%s': got %s, expected %s", data, hex, expected);
+
+	return strcmp(hex, expected) == 0;
+}
+
+static void test_xxh64(void)
+{
+	TEST_CHECK(hash_xxh64("", 0, 0) == 0xef46db3751d8e999ull);
+	TEST_CHECK(digest_is(HASH_xxh64, "", "ef46db3751d8e999"));
+	TEST_CHECK(digest_is(HASH_xxh64, "abc", "44bc2cf5ad770999"));
+	TEST_CHECK(digest_is(HASH_xxh64,
+			     "Nobody inspects the spammish repetition",
+			     "fbcea83c8a378bf1"));
+	TEST_CHECK(hash_xxh64("abc", 3, 1) != hash_xxh64("abc", 3, 0));
+}
+
+static void test_md5(void)
+{
+	TEST_CHECK(digest_is(HASH_md5, "", "d41d8cd98f00b204e9800998ecf8427e"));
+	TEST_CHECK(digest_is(HASH_md5, "abc",
+			     "900150983cd24fb0d6963f7d28e17f72"));
+	TEST_CHECK(digest_is(HASH_md5,
+			     "The quick brown fox jumps over the lazy dog",
+			     "9e107d9d372bb6826bd81d3542a419d6"));
+	TEST_CHECK(digest_is(HASH_md5,
+			     "1234567890123456789012345678901234567890"
+			     "1234567890123456789012345678901234567890",
+			     "57edf4a22be3c955ac49da2e2107b67a"));
+}
+
+static void test_sha256(void)
+{
+	TEST_CHECK(digest_is(HASH_sha256, "",
+			     "e3b0c44298fc1c149afbf4c8996fb924"
+			     "27ae41e4649b934ca495991b7852b855"));
+	TEST_CHECK(digest_is(HASH_sha256, "abc",
+			     "ba7816bf8f01cfea414140de5dae2223"
+			     "b00361a396177a9cb410ff61f20015ad"));
+	TEST_CHECK(digest_is(HASH_sha256,
+			     "abcdbcdecdefdefgefghfghighijhijk"
+			     "ijkljklmklmnlmnomnopnopq",
+			     "248d6a61d20638b8e5c026930c3e6039"
+			     "a33ce45964ff2167f6ecedd419db06c1"));
+}
+
+static void test_names(void)
+{
+	enum hash_algorithm algorithm;
+
+	TEST_CHECK(hash_algorithm_from_name("md5", 3, &algorithm) &&
+		   algorithm == HASH_md5);
+	TEST_CHECK(hash_algorithm_from_name("sha256", 6, &algorithm) &&
+		   algorithm == HASH_sha256);
+	TEST_CHECK(hash_algorithm_from_name("xxh64", 5, &algorithm) &&
+		   algorithm == HASH_xxh64);
+	TEST_CHECK(!hash_algorithm_from_name("sha", 3, &algorithm));
+	TEST_CHECK(!hash_algorithm_from_name("md55", 4, &algorithm));
+}
+
+TEST_LIST = {
+	{ "xxh64", test_xxh64 },
+	{ "md5", test_md5 },
+	{ "sha256", test_sha256 },
+	{ "algorithm names", test_names },
+	{ NULL, NULL }
+};
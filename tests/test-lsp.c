@@ -0,0 +1,197 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "lsp.h"
+#include "test.h"
+
+#define INITIALIZE \
+	"{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\"," \
+	"\"params\":{\"capabilities\":{}}}"
+#define SHUTDOWN "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"shutdown\"}"
+#define EXIT "{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}"
+
+#define OPEN(text) \
+	"{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\"," \
+	"\"params\":{\"textDocument\":{\"uri\":\"file:///meson.build\"," \
+	"\"languageId\":\"meson\",\"version\":1,\"text\":\"" text "\"}}}"
+
+#define CHANGE(changes) \
+	"{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\"," \
+	"\"params\":{\"textDocument\":{\"uri\":\"file:///meson.build\"," \
+	"\"version\":2},\"contentChanges\":[" changes "]}}"
+
+#define RANGE(l1, c1, l2, c2, text) \
+	"{\"range\":{\"start\":{\"line\":" #l1 ",\"character\":" #c1 "}," \
+	"\"end\":{\"line\":" #l2 ",\"character\":" #c2 "}},\"text\":\"" \
+	text "\"}"
+
+#define DIAGNOSTIC(line, character, message) \
+	"\"diagnostics\":[{\"range\":{" \
+	"\"start\":{\"line\":" #line ",\"character\":" #character "}," \
+	"\"end\":{\"line\":" #line ",\"character\":" #character "}}," \
+	"\"severity\":1,\"source\":\"meson-c\",\"message\":\"" message "\"}]"
+
+/*
+ * Frames the messages, serves them and returns the exit status and the
+ * bodies of all replies, one per line.
+ */
+static int serve(const char *const *messages, char *output, size_t size)
+{
+	FILE *in = tmpfile();
+	FILE *out = tmpfile();
+	char header[64];
+	size_t n = 0;
+	size_t length = 0;
+	int status = 0;
+
+	TEST_ASSERT(in != NULL && out != NULL);
+	for (; *messages != NULL; messages++) {
+		fprintf(in, "Content-Length: %zu\r\n\r\n%s",
+			strlen(*messages), *messages);
+	}
+	rewind(in);
+	status = lsp_serve(in, out);
+	rewind(out);
+
+	while (fgets(header, sizeof(header), out) != NULL) {
+		TEST_ASSERT(sscanf(header, "Content-Length: %zu", &length) == 1);
+		TEST_ASSERT(fgets(header, sizeof(header), out) != NULL);
+		TEST_ASSERT(n + length + 2 <= size);
+		TEST_ASSERT(fread(output + n, 1, length, out) == length);
+		n += length;
+		output[n++] = '\n';
+	}
+	output[n] = '\0';
+	fclose(in);
+	fclose(out);
+
+	return status;
+}
+
+/* Returns the n-th line of output. */
+static const char *reply(const char *output, int n, char *line,
+			 size_t size)
+{
+	const char *end = NULL;
+
+	for (; n > 0 && output != NULL; n--) {
+		output = strchr(output, '\n');
+		output = output != NULL ? output + 1 : NULL;
+	}
+	TEST_ASSERT(output != NULL && (end = strchr(output, '\n')) != NULL);
+	TEST_ASSERT((size_t) (end - output) < size);
+	memcpy(line, output, (size_t) (end - output));
+	line[end - output] = '\0';
+
+	return line;
+}
+
+#define CHECK_REPLY(output, n, expected) do {				\
+	char line_[1024];						\
+	TEST_CHECK(strstr(reply(output, n, line_, sizeof(line_)),	\
+			  expected) != NULL);				\
+	TEST_MSG("expected: %s\ngot: %s", expected, line_);		\
+} while (0)
+
+static void test_lifecycle(void)
+{
+	char output[4096];
+	const char *const session[] = {
+		INITIALIZE,
+		"{\"jsonrpc\":\"2.0\",\"method\":\"initialized\",\"params\":{}}",
+		"{\"jsonrpc\":\"2.0\",\"id\":\"x\",\"method\":\"hover\"}",
+		SHUTDOWN,
+		"{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"initialize\"}",
+		EXIT,
+		NULL
+	};
+	const char *const no_shutdown[] = { INITIALIZE, EXIT, NULL };
+	const char *const eof[] = { INITIALIZE, NULL };
+
+	TEST_CHECK(serve(session, output, sizeof(output)) == EXIT_SUCCESS);
+	CHECK_REPLY(output, 0, "\"id\":1,\"result\":{\"capabilities\":"
+		    "{\"textDocumentSync\":{\"openClose\":true,\"change\":2}}");
+	CHECK_REPLY(output, 1, "\"id\":\"x\",\"error\":{\"code\":-32601");
+	CHECK_REPLY(output, 2, "\"id\":2,\"result\":null");
+	CHECK_REPLY(output, 3, "\"id\":3,\"error\":{\"code\":-32600");
+
+	TEST_CHECK(serve(no_shutdown, output, sizeof(output)) == EXIT_FAILURE);
+	TEST_CHECK(serve(eof, output, sizeof(output)) == EXIT_FAILURE);
+}
+
+static void test_diagnostics(void)
+{
+	char output[4096];
+	const char *const session[] = {
+		INITIALIZE,
+		OPEN("a = [1,\\n  2 )\\n"),
+		CHANGE(RANGE(1, 4, 1, 5, "]")),
+		CHANGE(RANGE(0, 0, 0, 0, "b = 'c\\\"'\\n")),
+		CHANGE("{\"text\":\"x = (\"}"),
+		"{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didClose\","
+		"\"params\":{\"textDocument\":"
+		"{\"uri\":\"file:///meson.build\"}}}",
+		CHANGE("{\"text\":\"x = (\"}"),
+		SHUTDOWN,
+		EXIT,
+		NULL
+	};
+
+	TEST_CHECK(serve(session, output, sizeof(output)) == EXIT_SUCCESS);
+	CHECK_REPLY(output, 1, "\"uri\":\"file:///meson.build\"");
+	CHECK_REPLY(output, 1, DIAGNOSTIC(1, 4,
+		    "array: expected closing bracket"));
+	CHECK_REPLY(output, 2, "\"diagnostics\":[]");
+	CHECK_REPLY(output, 3, "\"diagnostics\":[]");
+	CHECK_REPLY(output, 4, "\"diagnostics\":[{");
+	/* Nothing is published for a closed document */
+	CHECK_REPLY(output, 5, "\"id\":2,\"result\":null");
+}
+
+static void test_positions(void)
+{
+	char output[4096];
+	/* U+1F600 takes two UTF-16 code units */
+	const char *const session[] = {
+		INITIALIZE,
+		OPEN("x = '\\u00e9\\ud83d\\ude00'\\n"),
+		CHANGE(RANGE(0, 9, 0, 9, " = 1")),
+		CHANGE(RANGE(0, 9, 0, 99, "")),
+		SHUTDOWN,
+		EXIT,
+		NULL
+	};
+
+	TEST_CHECK(serve(session, output, sizeof(output)) == EXIT_SUCCESS);
+	CHECK_REPLY(output, 1, "\"diagnostics\":[]");
+	CHECK_REPLY(output, 2, "\"character\":10}");
+	CHECK_REPLY(output, 3, "\"diagnostics\":[]");
+}
+
+TEST_LIST = {
+	{ "lifecycle", test_lifecycle },
+	{ "diagnostics", test_diagnostics },
+	{ "utf-16 positions", test_positions },
+	{ NULL, NULL }
+};
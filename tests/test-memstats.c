@@ -0,0 +1,121 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "memstats.h"
+#include "parser.h"
+
+static void test_balance(void)
+{
+	struct mem_stats before;
+	struct mem_stats after;
+	struct parse_result res;
+
+	if (!mem_stats_get(&before)) {
+		/* Built without MEM_STATS=1, nothing is counted. */
+		TEST_CHECK(before.peak == 0);
+		return;
+	}
+
+	/* Let lazily allocated buffers (trace events) settle first. */
+	res = parse(CSTRING("warm_up"));
+	parse_result_free(&res);
+
+	mem_stats_reset();
+	TEST_CHECK(mem_stats_get(&before));
+
+	res = parse(CSTRING("foo = ['a', 'b'] + bar(1, x: {'k': 2})"));
+	TEST_CHECK(res.success);
+	parse_result_free(&res);
+
+	TEST_CHECK(mem_stats_get(&after));
+	TEST_CHECK(after.live == before.live);
+	TEST_CHECK(after.peak > after.live);
+
+	TEST_CHECK(after.tags[MEM_AST_TAG(AST_ARRAY)].allocs == 1);
+	TEST_CHECK(after.tags[MEM_AST_TAG(AST_DICTIONARY)].allocs == 1);
+	TEST_CHECK(after.tags[MEM_AST_TAG(AST_KEYWORD_ARG)].allocs == 1);
+	TEST_CHECK(after.tags[MEM_AST_TAG(AST_STRING)].allocs == 3);
+	TEST_CHECK(after.tags[MEM_AST_TAG(AST_FOREACH)].allocs == 0);
+	TEST_CHECK(after.tags[MEM_STRING].allocs > 0);
+	TEST_CHECK(after.tags[MEM_LEXER].allocs == 1);
+	for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+		TEST_CHECK_(after.tags[i].live == before.tags[i].live,
+			    "%s is balanced", mem_tag_name(i));
+		TEST_CHECK(after.tags[i].allocs == after.tags[i].frees);
+	}
+}
+
+static void test_lexeme_growth(void)
+{
+	struct mem_stats stats;
+	struct parse_result res;
+	char source[1024];
+
+	if (!mem_stats_get(&stats)) {
+		return;
+	}
+	mem_stats_reset();
+
+	/* Identifier longer than the initial lexeme buffer. */
+	memset(source, 'x', sizeof(source) - 1);
+	source[sizeof(source) - 1] = '\0';
+
+	res = parse(string_from_buf(source));
+	TEST_CHECK(res.success);
+	parse_result_free(&res);
+
+	TEST_CHECK(mem_stats_get(&stats));
+	TEST_CHECK(stats.tags[MEM_LEXER].allocs > 1);
+	TEST_CHECK(stats.tags[MEM_LEXER].allocs == stats.tags[MEM_LEXER].frees);
+	TEST_CHECK(stats.tags[MEM_LEXER].live == 0);
+}
+
+static void test_json(void)
+{
+	struct mem_stats stats;
+	char buffer[8192];
+	FILE *f = NULL;
+	size_t n = 0;
+
+	mem_stats_get(&stats);
+
+	TEST_ASSERT((f = tmpfile()) != NULL);
+	TEST_CHECK(mem_stats_write(f, &stats));
+	rewind(f);
+	n = fread(buffer, 1, sizeof(buffer) - 1, f);
+	buffer[n] = '\0';
+	fclose(f);
+
+	TEST_CHECK(strncmp(buffer, "{\"live\":", 8) == 0);
+	TEST_CHECK(strstr(buffer, "\"AST_ARRAY\":{\"allocs\":") != NULL);
+	TEST_CHECK(buffer[n - 1] == '}');
+}
+
+TEST_LIST = {
+	{ "balanced counters", test_balance },
+	{ "lexeme reallocation", test_lexeme_growth },
+	{ "json output", test_json },
+	{ NULL, NULL }
+};
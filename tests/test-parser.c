@@ -468,6 +468,13 @@ static void test_application()
 	PASS("f(a:1)", "(app (id f) kw-args:(((id a) (num 1))))");
 	PASS("f(a,k:v)", "(app (id f) args:((id a)) kw-args:(((id k) (id v))))");
 	PASS("o.f(x)", "(app (member (id o) (id f)) args:((id x)))");
+	PASS("'@0@'.format(x)",
+	     "(app (member (str `@0@`) (id format)) args:((id x)))");
+	PASS("'a,b'.split(',')[0]",
+	     "(index (app (member (str `a,b`) (id split)) args:((str `,`))) (num 0))");
+
+	FAIL("'x'(y)", "string is not callable");
+	FAIL("'x'[0](y)", "string is not callable");
 
 	FAIL("f(", "application: expected argument");
 	FAIL("f(,", "application: expected argument");
@@ -670,6 +677,30 @@ static void test_selection(void)
 	FAIL("if true () endif", "invalid expression");
 }
 
+static bool location_is(const char *source, size_t line, size_t column)
+{
+	struct parse_result res;
+	bool pass = false;
+
+	res = parse(string_from_buf(source));
+	if (!res.success) {
+		pass = res.location.line == line &&
+			res.location.column == column;
+		TEST_MSG("got %zu:%zu", res.location.line, res.location.column);
+	}
+	parse_result_free(&res);
+
+	return pass;
+}
+
+static void test_location(void)
+{
+	TEST_CHECK(location_is("[", 1, 2));
+	TEST_CHECK(location_is("a = [1,\n  2", 2, 4));
+	TEST_CHECK(location_is("# comment\nif true\n  x = 1\n", 4, 1));
+	TEST_CHECK(location_is("\n\nfoo(a: 1, 2)", 3, 12));
+}
+
 TEST_LIST = {
 	{ "identifiers", test_identifier },
 	{ "boolean literals", test_boolean },
@@ -693,5 +724,6 @@ TEST_LIST = {
 	{ "sequence of statements", test_sequence },
 	{ "iteration statements", test_iteration },
 	{ "selection statements", test_selection },
+	{ "error locations", test_location },
 	{ NULL, NULL }
 };
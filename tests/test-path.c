@@ -0,0 +1,196 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "path.h"
+#include <stdio.h>
+
+static struct path_table table;
+
+static bool is(struct string s, const char *expected)
+{
+	bool pass = !string_is_null(s) &&
+		string_equal(s, string_from_buf(expected));
+
+	TEST_MSG("got `%.*s', expected `%s'",
+		 (int) string_length(s), string_buffer(s), expected);
+	return pass;
+}
+
+static const struct path *path(const char *s)
+{
+	return path_intern(&table, NULL, string_from_buf(s));
+}
+
+static bool normalizes_to(const char *s, const char *expected)
+{
+	struct string text = path_string(path(s));
+	bool pass = is(text, expected);
+
+	string_free(&text);
+	return pass;
+}
+
+static bool relative_is(const char *p, const char *from, const char *expected)
+{
+	struct string text = path_relative(&table, path(p), path(from));
+	bool pass = false;
+
+	if (expected == NULL) {
+		pass = string_is_null(text);
+	} else {
+		pass = is(text, expected);
+	}
+	string_free(&text);
+	return pass;
+}
+
+static void test_atoms(void)
+{
+	struct atom_table t;
+	const struct atom *a = NULL;
+	char name[16];
+
+	atom_table_init(&t);
+	a = atom_intern(&t, CSTRING("src"));
+	TEST_ASSERT(a != NULL);
+	TEST_CHECK(atom_intern(&t, CSTRING("src")) == a);
+	TEST_CHECK(atom_intern(&t, CSTRING("sr")) != a);
+	TEST_CHECK(string_equal(atom_string(a), CSTRING("src")));
+	TEST_CHECK(a->text[a->length] == '\0');
+
+	/* Survives growing the table. */
+	for (int i = 0; i < 1000; i++) {
+		snprintf(name, sizeof(name), "atom%d", i);
+		TEST_CHECK(atom_intern(&t, string_from_buf(name)) != NULL);
+	}
+	TEST_CHECK(t.count == 1002);
+	TEST_CHECK(atom_intern(&t, CSTRING("src")) == a);
+	TEST_CHECK(atom_intern(&t, CSTRING("atom500")) ==
+		   atom_intern(&t, CSTRING("atom500")));
+
+	atom_table_free(&t);
+}
+
+static void test_normalize(void)
+{
+	TEST_ASSERT(path_table_init(&table));
+
+	TEST_CHECK(normalizes_to("", "."));
+	TEST_CHECK(normalizes_to(".", "."));
+	TEST_CHECK(normalizes_to("/", "/"));
+	TEST_CHECK(normalizes_to("src", "src"));
+	TEST_CHECK(normalizes_to("./src//lib/", "src/lib"));
+	TEST_CHECK(normalizes_to("src/./lib/../main.c", "src/main.c"));
+	TEST_CHECK(normalizes_to("/usr/include", "/usr/include"));
+	TEST_CHECK(normalizes_to("//usr/../lib", "/lib"));
+	TEST_CHECK(normalizes_to("/..", "/"));
+	TEST_CHECK(normalizes_to("..", ".."));
+	TEST_CHECK(normalizes_to("a/../..", ".."));
+	TEST_CHECK(normalizes_to("../../x/..", "../.."));
+
+	path_table_free(&table);
+}
+
+static void test_identity(void)
+{
+	const struct path *p = NULL;
+
+	TEST_ASSERT(path_table_init(&table));
+	p = path("src/lib/a.c");
+
+	TEST_CHECK(p == path("./src/lib//a.c"));
+	TEST_CHECK(p == path("src/x/../lib/a.c"));
+	TEST_CHECK(p != path("/src/lib/a.c"));
+	TEST_CHECK(p != path("src/lib/b.c"));
+	TEST_CHECK(p->depth == 3);
+	TEST_CHECK(path_parent(p) == path("src/lib"));
+	TEST_CHECK(path_parent(path("")) == path("."));
+	TEST_CHECK(string_equal(path_name(p), CSTRING("a.c")));
+
+	path_table_free(&table);
+}
+
+static void test_join(void)
+{
+	const struct path *src = NULL;
+	struct string s;
+
+	TEST_ASSERT(path_table_init(&table));
+	src = path("src");
+
+	TEST_CHECK(path_intern(&table, src, CSTRING("lib/a.c")) ==
+		   path("src/lib/a.c"));
+	TEST_CHECK(path_intern(&table, src, CSTRING("../include")) ==
+		   path("include"));
+	TEST_CHECK(path_intern(&table, src, CSTRING("/usr")) == path("/usr"));
+	TEST_CHECK(path_intern(&table, src, CSTRING("")) == src);
+
+	s = path_string(path_intern(&table, path("/opt"), CSTRING("x/y")));
+	TEST_CHECK(is(s, "/opt/x/y"));
+	string_free(&s);
+
+	path_table_free(&table);
+}
+
+static void test_ancestor(void)
+{
+	TEST_ASSERT(path_table_init(&table));
+
+	TEST_CHECK(path_common_ancestor(path("a/b/c"), path("a/b/d/e")) ==
+		   path("a/b"));
+	TEST_CHECK(path_common_ancestor(path("a/b"), path("a/b/c")) ==
+		   path("a/b"));
+	TEST_CHECK(path_common_ancestor(path("a"), path("b")) == path("."));
+	TEST_CHECK(path_common_ancestor(path("/a"), path("/b")) == path("/"));
+	TEST_CHECK(path_common_ancestor(path("/a"), path("a")) == NULL);
+
+	path_table_free(&table);
+}
+
+static void test_relative(void)
+{
+	TEST_ASSERT(path_table_init(&table));
+
+	TEST_CHECK(relative_is("src/a.c", "build", "../src/a.c"));
+	TEST_CHECK(relative_is("src/a.c", "src", "a.c"));
+	TEST_CHECK(relative_is("src", "src/lib/x", "../.."));
+	TEST_CHECK(relative_is("src", "src", "."));
+	TEST_CHECK(relative_is("/usr/lib", "/usr/include/sys", "../../lib"));
+	TEST_CHECK(relative_is("../x", "a", "../../x"));
+	TEST_CHECK(relative_is("x", "../a", NULL));
+	TEST_CHECK(relative_is("/usr", "build", NULL));
+
+	path_table_free(&table);
+}
+
+TEST_LIST = {
+	{ "atom interning", test_atoms },
+	{ "normalization", test_normalize },
+	{ "identity", test_identity },
+	{ "joining", test_join },
+	{ "common ancestor", test_ancestor },
+	{ "relative paths", test_relative },
+	{ NULL, NULL }
+};
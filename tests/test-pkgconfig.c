@@ -0,0 +1,228 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "pkgconfig.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * foo -> bar -> baz -> m
+ *   \      \      \--> glib (package glib-2.0)
+ *    \      \--> m, zlib
+ *     \--> zlib (package zlib)
+ */
+static struct pkgconfig_lib m, glib, zlib, baz, bar, foo;
+static const struct pkgconfig_lib *baz_deps[] = { &m, &glib };
+static const struct pkgconfig_lib *bar_deps[] = { &baz, &m, &zlib };
+static const struct pkgconfig_lib *foo_deps[] = { &bar, &zlib };
+
+static void setup(struct pkgconfig *pc)
+{
+	m = (struct pkgconfig_lib) { .name = CSTRING("m") };
+	glib = (struct pkgconfig_lib) {
+		.name = CSTRING("glib-2.0"), .package = CSTRING("glib-2.0")
+	};
+	zlib = (struct pkgconfig_lib) {
+		.name = CSTRING("z"), .package = CSTRING("zlib")
+	};
+	baz = (struct pkgconfig_lib) {
+		.name = CSTRING("baz"), .deps = baz_deps, .dep_count = 2
+	};
+	bar = (struct pkgconfig_lib) {
+		.name = CSTRING("bar"), .deps = bar_deps, .dep_count = 3
+	};
+	foo = (struct pkgconfig_lib) {
+		.name = CSTRING("foo"), .deps = foo_deps, .dep_count = 2
+	};
+	TEST_ASSERT(pkgconfig_init(pc));
+}
+
+static bool list_is(struct pkgconfig *pc, uint32_t id, const char *expected)
+{
+	const struct args *l = args_get(&pc->args, id);
+	char buffer[256];
+	size_t n = 0;
+
+	buffer[0] = '\0';
+	for (size_t i = 0; i < l->count && n < sizeof(buffer); i++) {
+		n += snprintf(buffer + n, sizeof(buffer) - n, "%s%s",
+			      i > 0 ? " " : "", l->items[i]->text);
+	}
+	TEST_MSG("got `%s', expected `%s'", buffer, expected);
+
+	return strcmp(buffer, expected) == 0;
+}
+
+static void test_closure(void)
+{
+	struct pkgconfig pc;
+	const struct pkgconfig_closure *c = NULL;
+	const char *error = NULL;
+	size_t count = 0;
+
+	setup(&pc);
+
+	TEST_ASSERT((c = pkgconfig_closure(&pc, &foo, &error)) != NULL);
+	TEST_CHECK(list_is(&pc, c->requires, "glib-2.0 zlib"));
+	TEST_CHECK(list_is(&pc, c->libs, "-lbar -lbaz -lm"));
+
+	TEST_ASSERT((c = pkgconfig_closure(&pc, &bar, &error)) != NULL);
+	TEST_CHECK(list_is(&pc, c->libs, "-lbaz -lm"));
+
+	/* Cached: nothing new is walked. */
+	count = pc.count;
+	TEST_CHECK(pkgconfig_closure(&pc, &foo, &error) ==
+		   pkgconfig_closure(&pc, &foo, &error));
+	TEST_CHECK(pc.count == count);
+
+	TEST_ASSERT((c = pkgconfig_closure(&pc, &m, &error)) != NULL);
+	TEST_CHECK(c->requires == ARGS_EMPTY && c->libs == ARGS_EMPTY);
+
+	pkgconfig_free(&pc);
+}
+
+static void test_diamond(void)
+{
+	/* a -> c, b and b -> c: b must be linked before c. */
+	struct pkgconfig_lib a, b, c, d;
+	const struct pkgconfig_lib *a_deps[] = { &c, &b };
+	const struct pkgconfig_lib *b_deps[] = { &c };
+	const struct pkgconfig_lib *d_deps[] = { &b, &a, &c };
+	const struct pkgconfig_closure *cl = NULL;
+	struct pkgconfig pc;
+	const char *error = NULL;
+
+	c = (struct pkgconfig_lib) { .name = CSTRING("C") };
+	b = (struct pkgconfig_lib) {
+		.name = CSTRING("B"), .deps = b_deps, .dep_count = 1
+	};
+	a = (struct pkgconfig_lib) {
+		.name = CSTRING("A"), .deps = a_deps, .dep_count = 2
+	};
+	d = (struct pkgconfig_lib) {
+		.name = CSTRING("D"), .deps = d_deps, .dep_count = 3
+	};
+	TEST_ASSERT(pkgconfig_init(&pc));
+
+	TEST_ASSERT((cl = pkgconfig_closure(&pc, &a, &error)) != NULL);
+	TEST_CHECK(list_is(&pc, cl->libs, "-lB -lC"));
+	TEST_ASSERT((cl = pkgconfig_closure(&pc, &d, &error)) != NULL);
+	TEST_CHECK(list_is(&pc, cl->libs, "-lA -lB -lC"));
+
+	pkgconfig_free(&pc);
+}
+
+static void test_cycle(void)
+{
+	struct pkgconfig pc;
+	const struct pkgconfig_lib *deps[] = { &foo };
+	const char *error = NULL;
+
+	setup(&pc);
+	m.deps = deps;
+	m.dep_count = 1;
+
+	TEST_CHECK(pkgconfig_closure(&pc, &foo, &error) == NULL);
+	TEST_CHECK(strcmp(error, "dependency cycle") == 0);
+
+	pkgconfig_free(&pc);
+}
+
+static void test_render(void)
+{
+	struct pkgconfig pc;
+	struct strbuf out;
+	const char *error = NULL;
+	struct pkgconfig_info info = {
+		.name = CSTRING("foo"),
+		.description = CSTRING("The foo library"),
+		.version = CSTRING("1.2.3"),
+		.url = NULL_STRING,
+		.prefix = CSTRING("/usr/local"),
+		.lib = &foo
+	};
+
+	setup(&pc);
+	strbuf_init(&out);
+
+	TEST_CHECK(pkgconfig_render(&pc, &info, &out, &error));
+	TEST_CHECK(string_equal(strbuf_string(&out), CSTRING(
+		"prefix=/usr/local\n"
+		"includedir=${prefix}/include\n"
+		"libdir=${prefix}/lib\n"
+		"\n"
+		"Name: foo\n"
+		"Description: The foo library\n"
+		"Version: 1.2.3\n"
+		"Requires.private: glib-2.0, zlib\n"
+		"Libs: -L${libdir} -lfoo\n"
+		"Libs.private: -lbar -lbaz -lm\n"
+		"Cflags: -I${includedir}\n")));
+	TEST_MSG("got:\n%.*s", (int) out.length, out.data);
+
+	strbuf_free(&out);
+	pkgconfig_free(&pc);
+}
+
+static void test_write(void)
+{
+	const char *path = NULL;
+	struct pkgconfig pc;
+	const char *error = NULL;
+	bool changed = false;
+	struct pkgconfig_info info = {
+		.name = CSTRING("baz"),
+		.description = CSTRING("Baz"),
+		.version = CSTRING("0.1"),
+		.url = CSTRING("https://example.org/baz"),
+		.prefix = CSTRING("/usr"),
+		.lib = &baz
+	};
+
+	setup(&pc);
+	test_dir_setup();
+	path = test_path("baz.pc");
+
+	TEST_CHECK(pkgconfig_write(&pc, &info, path, &changed, &error));
+	TEST_CHECK(changed);
+	TEST_CHECK(pkgconfig_write(&pc, &info, path, &changed, &error));
+	TEST_CHECK(!changed);
+
+	info.version = CSTRING("0.2");
+	TEST_CHECK(pkgconfig_write(&pc, &info, path, &changed, &error));
+	TEST_CHECK(changed);
+
+	test_dir_teardown();
+	pkgconfig_free(&pc);
+}
+
+TEST_LIST = {
+	{ "dependency closure", test_closure },
+	{ "static link order", test_diamond },
+	{ "dependency cycles", test_cycle },
+	{ "file contents", test_render },
+	{ "write if changed", test_write },
+	{ NULL, NULL }
+};
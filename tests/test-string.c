@@ -52,8 +52,144 @@ static void test_alloc(void)
 	string_free(&str);
 }
 
+static bool is(struct string s, const char *expected)
+{
+	bool pass = string_equal(s, string_from_buf(expected));
+
+	TEST_MSG("got `%.*s', expected `%s'",
+		 (int) string_length(s), string_buffer(s), expected);
+	return pass;
+}
+
+static void test_search(void)
+{
+	struct string s = CSTRING("-O2 -Wall -Wextra -DNDEBUG");
+	size_t pos = 0;
+
+	TEST_CHECK(string_contains(s, CSTRING("-Wextra")));
+	TEST_CHECK(!string_contains(s, CSTRING("-Werror")));
+	TEST_CHECK(string_contains(s, CSTRING("")));
+	TEST_CHECK(string_find(s, CSTRING("-W"), &pos) && pos == 4);
+	TEST_CHECK(string_find(s, CSTRING("NDEBUG"), &pos) && pos == 20);
+	TEST_CHECK(!string_find(s, CSTRING("NDEBUGX"), &pos));
+
+	TEST_CHECK(string_startswith(s, CSTRING("-O2")));
+	TEST_CHECK(!string_startswith(CSTRING("-O"), CSTRING("-O2")));
+	TEST_CHECK(string_endswith(s, CSTRING("NDEBUG")));
+	TEST_CHECK(!string_endswith(s, CSTRING("-O2")));
+
+	TEST_CHECK(string_count(s, CSTRING("-W")) == 2);
+	TEST_CHECK(string_count(CSTRING("aaaa"), CSTRING("aa")) == 2);
+	TEST_CHECK(string_count(s, CSTRING("")) == 0);
+}
+
+static void test_strip(void)
+{
+	struct string s = CSTRING(" \t 1.2.3\n ");
+	struct string r;
+
+	r = string_strip(s, NULL_STRING);
+	TEST_CHECK(is(r, "1.2.3"));
+	TEST_CHECK(string_buffer(r) == string_buffer(s) + 3);
+
+	TEST_CHECK(is(string_strip(CSTRING("xxabcxyx"), CSTRING("xy")), "abc"));
+	TEST_CHECK(is(string_strip(CSTRING("   "), NULL_STRING), ""));
+	TEST_CHECK(is(string_strip(CSTRING(""), NULL_STRING), ""));
+}
+
+static void test_replace(void)
+{
+	struct string s = CSTRING("a.b.c");
+	struct string r;
+
+	r = string_replace(s, CSTRING("."), CSTRING("::"));
+	TEST_CHECK(is(r, "a::b::c"));
+	string_free(&r);
+
+	r = string_replace(s, CSTRING(".b"), CSTRING(""));
+	TEST_CHECK(is(r, "a.c"));
+	string_free(&r);
+
+	/* Nothing replaced, the source is returned without a copy. */
+	r = string_replace(s, CSTRING("/"), CSTRING("\\"));
+	TEST_CHECK(is(r, "a.b.c"));
+	TEST_CHECK(string_buffer(r) == string_buffer(s));
+	string_free(&r);
+
+	/* An empty pattern matches around every character. */
+	r = string_replace(CSTRING("abc"), CSTRING(""), CSTRING("-"));
+	TEST_CHECK(is(r, "-a-b-c-"));
+	string_free(&r);
+
+	r = string_replace(CSTRING(""), CSTRING(""), CSTRING("x"));
+	TEST_CHECK(is(r, "x"));
+	string_free(&r);
+
+	r = string_replace(CSTRING("h\xc3\xa9"), CSTRING(""), CSTRING("."));
+	TEST_CHECK(is(r, ".h.\xc3\xa9."));
+	string_free(&r);
+
+	r = string_replace(CSTRING("ab"), CSTRING(""), CSTRING(""));
+	TEST_CHECK(is(r, "ab"));
+	string_free(&r);
+}
+
+static void test_split(void)
+{
+	static const char *const fields[] = { "a", "", "b", "" };
+	static const char *const words[] = { "-O2", "-g", "-Wall" };
+	struct string_split it;
+	struct string part;
+	size_t n = 0;
+
+	string_split_init(&it, CSTRING("a,,b,"), CSTRING(","));
+	while (string_split_next(&it, &part)) {
+		TEST_ASSERT(n < ARRAY_SIZE(fields));
+		TEST_CHECK(is(part, fields[n++]));
+	}
+	TEST_CHECK(n == ARRAY_SIZE(fields));
+
+	n = 0;
+	string_split_init(&it, CSTRING("  -O2 \t-g\n-Wall  "), NULL_STRING);
+	while (string_split_next(&it, &part)) {
+		TEST_ASSERT(n < ARRAY_SIZE(words));
+		TEST_CHECK(is(part, words[n++]));
+	}
+	TEST_CHECK(n == ARRAY_SIZE(words));
+
+	string_split_init(&it, CSTRING("   "), NULL_STRING);
+	TEST_CHECK(!string_split_next(&it, &part));
+
+	string_split_init(&it, CSTRING(""), CSTRING(","));
+	TEST_CHECK(string_split_next(&it, &part) && is(part, ""));
+	TEST_CHECK(!string_split_next(&it, &part));
+}
+
+static void test_join(void)
+{
+	struct string parts[] = { CSTRING("usr"), CSTRING("local"), CSTRING("lib") };
+	struct string r;
+
+	r = string_join(CSTRING("/"), parts, ARRAY_SIZE(parts));
+	TEST_CHECK(is(r, "usr/local/lib"));
+	string_free(&r);
+
+	r = string_join(CSTRING(", "), parts, 1);
+	TEST_CHECK(is(r, "usr"));
+	string_free(&r);
+
+	r = string_join(CSTRING(", "), parts, 0);
+	TEST_CHECK(is(r, ""));
+	string_free(&r);
+}
+
 TEST_LIST = {
 	{ "literal strings", test_literal },
 	{ "allocated strings", test_alloc },
+	{ "search", test_search },
+	{ "strip", test_strip },
+	{ "replace", test_replace },
+	{ "split", test_split },
+	{ "join", test_join },
 	{ NULL, NULL }
 };
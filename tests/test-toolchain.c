@@ -0,0 +1,188 @@
+/*
+ * The MIT License
+ *
+ * Copyright 2021 Evgeny Ermakov <e.v.ermakov@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "toolchain.h"
+#include <stdlib.h>
+
+static char cc[512];
+static char cache[512];
+
+static const char *const fields[][2] = {
+	{ "id", "gcc" },
+	{ "version", "11.2.0" },
+	{ "search", "/usr/include\n/usr/lib\\x" },
+};
+
+#define FIELD_COUNT (sizeof(fields) / sizeof(fields[0]))
+
+static bool store(struct toolchain_cache *c, uint64_t env)
+{
+	struct toolchain_field f[FIELD_COUNT];
+
+	for (size_t i = 0; i < FIELD_COUNT; i++) {
+		f[i].key = string_from_buf(fields[i][0]);
+		f[i].value = string_from_buf(fields[i][1]);
+	}
+	return toolchain_cache_store(c, string_from_buf(cc), env, f,
+				     FIELD_COUNT);
+}
+
+static void check_fields(const struct toolchain_entry *e)
+{
+	TEST_ASSERT(e != NULL);
+	TEST_CHECK(e->count == FIELD_COUNT);
+	for (size_t i = 0; i < FIELD_COUNT; i++) {
+		struct string v = toolchain_entry_get(e,
+			string_from_buf(fields[i][0]));
+
+		TEST_CHECK(string_equal(v, string_from_buf(fields[i][1])));
+	}
+	TEST_CHECK(string_is_null(toolchain_entry_get(e, CSTRING("linker"))));
+}
+
+static void setup(void)
+{
+	test_dir_setup();
+	snprintf(cc, sizeof(cc), "%s", test_path("cc"));
+	snprintf(cache, sizeof(cache), "%s", test_path("toolchains"));
+	test_write_file("cc", "#!/bin/sh\n");
+}
+
+static void test_roundtrip(void)
+{
+	struct toolchain_cache c;
+	const char *names[] = { "CC", "CFLAGS" };
+	uint64_t env = toolchain_env_hash(names, 2);
+	bool changed = false;
+
+	setup();
+	toolchain_cache_init(&c);
+	TEST_CHECK(toolchain_cache_load(&c, cache));
+	TEST_CHECK(c.count == 0);
+	TEST_CHECK(toolchain_cache_lookup(&c, string_from_buf(cc), env) == NULL);
+
+	TEST_CHECK(store(&c, env));
+	TEST_CHECK(store(&c, env));
+	TEST_CHECK(c.count == 1);
+	check_fields(toolchain_cache_lookup(&c, string_from_buf(cc), env));
+	TEST_CHECK(toolchain_cache_save(&c, cache, &changed));
+	TEST_CHECK(changed);
+	toolchain_cache_free(&c);
+
+	toolchain_cache_init(&c);
+	TEST_CHECK(toolchain_cache_load(&c, cache));
+	check_fields(toolchain_cache_lookup(&c, string_from_buf(cc), env));
+	TEST_CHECK(toolchain_cache_save(&c, cache, &changed));
+	TEST_CHECK(!changed);
+	toolchain_cache_free(&c);
+	test_dir_teardown();
+}
+
+static void test_invalidation(void)
+{
+	struct toolchain_cache c;
+	const char *names[] = { "MESON_C_TEST_CC" };
+	uint64_t unset = 0, empty = 0, env = 0;
+
+	unsetenv(names[0]);
+	unset = toolchain_env_hash(names, 1);
+	setenv(names[0], "", 1);
+	empty = toolchain_env_hash(names, 1);
+	setenv(names[0], "clang", 1);
+	env = toolchain_env_hash(names, 1);
+	unsetenv(names[0]);
+	TEST_CHECK(unset != empty);
+	TEST_CHECK(empty != env);
+	TEST_CHECK(toolchain_env_hash(names, 1) == unset);
+
+	setup();
+	toolchain_cache_init(&c);
+	TEST_CHECK(!toolchain_cache_store(&c, CSTRING("/nonexistent/cc"),
+					  env, NULL, 0));
+	TEST_CHECK(!toolchain_cache_store(&c, string_from_buf(cc), env,
+					  &(struct toolchain_field) {
+						  CSTRING("bad key"), CSTRING("")
+					  }, 1));
+	TEST_CHECK(c.count == 0);
+	TEST_CHECK(store(&c, env));
+	TEST_CHECK(toolchain_cache_lookup(&c, string_from_buf(cc), env) != NULL);
+	TEST_CHECK(toolchain_cache_lookup(&c, string_from_buf(cc),
+					  unset) == NULL);
+
+	/* An upgraded compiler. */
+	test_write_file("cc", "#!/bin/sh\nexit 0\n");
+	TEST_CHECK(toolchain_cache_lookup(&c, string_from_buf(cc), env) == NULL);
+	TEST_CHECK(store(&c, env));
+	TEST_CHECK(toolchain_cache_lookup(&c, string_from_buf(cc), env) != NULL);
+
+	remove(cc);
+	TEST_CHECK(toolchain_cache_lookup(&c, string_from_buf(cc), env) == NULL);
+	toolchain_cache_free(&c);
+	test_dir_teardown();
+}
+
+static void test_damaged(void)
+{
+	struct toolchain_cache c;
+
+	setup();
+	toolchain_cache_init(&c);
+
+	test_write_file("toolchains", "# meson-c toolchain cache, version 0\n"
+			"compiler 1 2 3 0000000000000000 /usr/bin/cc\n");
+	TEST_CHECK(toolchain_cache_load(&c, cache));
+	TEST_CHECK(c.count == 0);
+
+	test_write_file("toolchains", "# meson-c toolchain cache, version 1\n"
+			"compiler 1 2 3 0000000000000000 /usr/bin/cc\n"
+			"field id gcc\n"
+			"compiler 1 x 3 0000000000000000 /usr/bin/c++\n");
+	TEST_CHECK(toolchain_cache_load(&c, cache));
+	TEST_CHECK(c.count == 0);
+
+	test_write_file("toolchains", "# meson-c toolchain cache, version 1\n"
+			"field id gcc\n");
+	TEST_CHECK(toolchain_cache_load(&c, cache));
+	TEST_CHECK(c.count == 0);
+
+	test_write_file("toolchains", "# meson-c toolchain cache, version 1\n"
+			"compiler 1 -2 3 00000000000000ff /usr/bin/cc\n"
+			"field id gcc\n");
+	TEST_CHECK(toolchain_cache_load(&c, cache));
+	TEST_ASSERT(c.count == 1);
+	TEST_CHECK(c.entries[0].mtime == -2);
+	TEST_CHECK(c.entries[0].env == 0xff);
+	TEST_CHECK(string_equal(c.entries[0].path, CSTRING("/usr/bin/cc")));
+
+	toolchain_cache_free(&c);
+	test_dir_teardown();
+}
+
+TEST_LIST = {
+	{ "save and load", test_roundtrip },
+	{ "invalidation", test_invalidation },
+	{ "damaged files", test_damaged },
+	{ NULL, NULL }
+};
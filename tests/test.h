@@ -27,8 +27,76 @@
 
 #include "defs.h"
 #include "acutest.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 
 #define PASS(...) TEST_CHECK(should_pass(__VA_ARGS__))
 #define FAIL(...) TEST_CHECK(should_fail(__VA_ARGS__))
 
+/*
+ * Scratch directory for tests that touch the file system, created by
+ * test_dir_setup() and removed with everything in it by
+ * test_dir_teardown().
+ */
+static char test_dir[64];
+
+static inline void test_dir_setup(void)
+{
+	strcpy(test_dir, "/tmp/meson-c-test-XXXXXX");
+	TEST_ASSERT(mkdtemp(test_dir) != NULL);
+}
+
+/* Path under the test directory, valid until the third next call. */
+static inline const char *test_path(const char *name)
+{
+	static char buffer[3][512];
+	static int next = 0;
+	char *p = buffer[next++ % 3];
+
+	snprintf(p, sizeof(buffer[0]), "%s/%s", test_dir, name);
+	return p;
+}
+
+static inline void test_write_file(const char *name, const char *contents)
+{
+	FILE *f = fopen(test_path(name), "wb");
+
+	TEST_ASSERT(f != NULL);
+	fputs(contents, f);
+	fclose(f);
+}
+
+static inline void test_remove_tree(const char *path)
+{
+	struct stat st;
+	struct dirent *entry = NULL;
+	DIR *dir = NULL;
+
+	if (lstat(path, &st) == 0 && S_ISDIR(st.st_mode) &&
+	    (dir = opendir(path)) != NULL) {
+		while ((entry = readdir(dir)) != NULL) {
+			char child[512];
+
+			if (!strcmp(entry->d_name, ".") ||
+			    !strcmp(entry->d_name, "..")) {
+				continue;
+			}
+			if (snprintf(child, sizeof(child), "%s/%s", path,
+				     entry->d_name) < (int) sizeof(child)) {
+				test_remove_tree(child);
+			}
+		}
+		closedir(dir);
+	}
+	remove(path);
+}
+
+static inline void test_dir_teardown(void)
+{
+	test_remove_tree(test_dir);
+	test_dir[0] = '\0';
+}
+
 #endif /* TEST_H */